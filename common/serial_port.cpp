@@ -0,0 +1,322 @@
+#include "serial_port.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint64_t kWakeToken = UINT64_MAX;
+
+// ==================== LineBuffer ====================
+LineBuffer::LineBuffer(size_t capacity)
+    : data(capacity), head(0), count(0), scanned(0), discarding(false), dropped(0) {}
+
+long LineBuffer::readFrom(int fd) {
+    size_t capacity = data.size();
+    if (count == capacity) {
+        // Буфер забит строкой без '\n': выбрасываем ее и ждем следующую
+        dropped += count;
+        clear();
+        discarding = true;
+    }
+
+    size_t tail = (head + count) % capacity;
+    size_t freeBytes = capacity - count;
+    iovec regions[2];
+    int regionCount = 1;
+    regions[0].iov_base = &data[tail];
+    regions[0].iov_len = min(freeBytes, capacity - tail);
+    if (regions[0].iov_len < freeBytes) {
+        regions[1].iov_base = &data[0];
+        regions[1].iov_len = freeBytes - regions[0].iov_len;
+        regionCount = 2;
+    }
+
+    ssize_t bytes = readv(fd, regions, regionCount);
+    if (bytes > 0) {
+        count += static_cast<size_t>(bytes);
+    }
+    return static_cast<long>(bytes);
+}
+
+bool LineBuffer::hasLine() {
+    size_t capacity = data.size();
+    while (scanned < count) {
+        if (data[(head + scanned) % capacity] != '\n') {
+            ++scanned;
+            continue;
+        }
+        if (!discarding) {
+            return true;
+        }
+        // Конец выброшенной строки: пропускаем его здесь, чтобы он не считался строкой
+        dropped += scanned + 1;
+        discarding = false;
+        head = (head + scanned + 1) % capacity;
+        count -= scanned + 1;
+        scanned = 0;
+    }
+    return false;
+}
+
+bool LineBuffer::nextLine(string& line) {
+    if (!hasLine()) {
+        return false;
+    }
+    size_t capacity = data.size();
+    size_t length = scanned;
+    line.clear();
+    for (size_t i = 0; i < length; ++i) {
+        line.push_back(data[(head + i) % capacity]);
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    head = (head + length + 1) % capacity;
+    count -= length + 1;
+    scanned = 0;
+    return true;
+}
+
+void LineBuffer::clear() {
+    head = 0;
+    count = 0;
+    scanned = 0;
+    discarding = false;
+}
+
+// ==================== SerialMultiplexer ====================
+static speed_t toSpeed(int baudRate) {
+    switch (baudRate) {
+        case 1200: return B1200;
+        case 2400: return B2400;
+        case 4800: return B4800;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default: return B9600;
+    }
+}
+
+SerialMultiplexer::SerialMultiplexer(int baudRate, chrono::milliseconds reconnectDelay)
+    : baudRate(baudRate), maxRate(0.0), reconnectDelay(reconnectDelay) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        cerr << "Error: epoll/eventfd setup failed: " << strerror(errno) << endl;
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeToken;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+SerialMultiplexer::~SerialMultiplexer() {
+    for (size_t i = 0; i < ports.size(); ++i) {
+        closePort(i);
+    }
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+size_t SerialMultiplexer::addPort(const string& path) {
+    auto now = chrono::steady_clock::now();
+    Port port = {path, -1, LineBuffer(), now, 0.0, now, false, now};
+    ports.push_back(port);
+    openPort(ports.size() - 1);
+    return ports.size() - 1;
+}
+
+bool SerialMultiplexer::isOpen(size_t port) const {
+    return port < ports.size() && ports[port].fd >= 0;
+}
+
+void SerialMultiplexer::setMaxRate(double linesPerSecond) {
+    maxRate = linesPerSecond > 0.0 ? linesPerSecond : 0.0;
+}
+
+void SerialMultiplexer::poll(int timeoutMs, const LineHandler& onLine) {
+    // Сначала переоткрываем порты, у которых подошло время повтора,
+    // и возобновляем порты, которым снова хватает квоты
+    auto now = chrono::steady_clock::now();
+    for (size_t i = 0; i < ports.size(); ++i) {
+        if (ports[i].fd < 0 && ports[i].retryAt <= now) {
+            openPort(i);
+        } else if (ports[i].fd >= 0 && ports[i].throttled && ports[i].resumeAt <= now) {
+            ports[i].throttled = false;
+            deliverLines(i, onLine);
+            if (!ports[i].throttled) {
+                setWatching(i, true);
+            }
+        }
+    }
+
+    epoll_event events[32];
+    int ready = epoll_wait(epollFd, events, 32, nextWakeTimeout(timeoutMs));
+    if (ready < 0 && errno != EINTR) {
+        cerr << "Error: epoll_wait failed: " << strerror(errno) << endl;
+        return;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+        if (events[i].data.u64 == kWakeToken) {
+            uint64_t value;
+            while (read(wakeFd, &value, sizeof(value)) > 0) {}
+            continue;
+        }
+        size_t index = static_cast<size_t>(events[i].data.u64);
+        if (ports[index].throttled) {
+            // Приостановленный порт сообщает только об обрыве (EPOLLHUP/EPOLLERR)
+            cerr << "Warning: Serial port disconnected: " << ports[index].path << endl;
+            closePort(index);
+            continue;
+        }
+        readPort(index, onLine);
+    }
+}
+
+void SerialMultiplexer::wakeup() {
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void SerialMultiplexer::openPort(size_t index) {
+    Port& port = ports[index];
+    port.fd = open(port.path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (port.fd < 0) {
+        cerr << "Error: Failed to open serial port: " << port.path << " (" << strerror(errno) << ")" << endl;
+        port.retryAt = chrono::steady_clock::now() + reconnectDelay;
+        return;
+    }
+
+    // Сырой режим без эха и построчной обработки; не tty (FIFO, pty-файл) оставляем как есть
+    termios tty = {};
+    if (tcgetattr(port.fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, toSpeed(baudRate));
+        cfsetospeed(&tty, toSpeed(baudRate));
+        tty.c_cflag |= CLOCAL | CREAD;
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 0;
+        if (tcsetattr(port.fd, TCSANOW, &tty) != 0) {
+            cerr << "Warning: Failed to configure serial port: " << port.path << endl;
+        }
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, port.fd, &event) != 0) {
+        cerr << "Error: Can't watch serial port: " << port.path << " (" << strerror(errno) << ")" << endl;
+        closePort(index);
+        return;
+    }
+
+    port.buffer.clear();
+    port.tokens = max(1.0, maxRate);
+    port.refilledAt = chrono::steady_clock::now();
+    port.throttled = false;
+    cout << "Opened serial port: " << port.path << endl;
+}
+
+void SerialMultiplexer::closePort(size_t index) {
+    Port& port = ports[index];
+    if (port.fd < 0) {
+        return;
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, port.fd, nullptr);
+    close(port.fd);
+    port.fd = -1;
+    port.retryAt = chrono::steady_clock::now() + reconnectDelay;
+}
+
+void SerialMultiplexer::readPort(size_t index, const LineHandler& onLine) {
+    Port& port = ports[index];
+    long bytes = port.buffer.readFrom(port.fd);
+    if (bytes < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (bytes <= 0) {
+        // Устройство отключено или закрыт другой конец pty: переоткроем позже
+        cerr << "Warning: Serial port disconnected: " << port.path << endl;
+        closePort(index);
+        return;
+    }
+
+    deliverLines(index, onLine);
+}
+
+void SerialMultiplexer::deliverLines(size_t index, const LineHandler& onLine) {
+    Port& port = ports[index];
+    string line;
+    while (port.buffer.hasLine()) {
+        if (!takeToken(port)) {
+            // Квота кончилась: не читаем порт, пока не наберется следующая строка
+            port.throttled = true;
+            port.resumeAt = port.refilledAt + chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>((1.0 - port.tokens) / maxRate));
+            setWatching(index, false);
+            return;
+        }
+        // hasLine уже пропустил хвост выброшенной строки, так что токен тратится на выданную строку
+        port.buffer.nextLine(line);
+        onLine(index, line);
+    }
+}
+
+bool SerialMultiplexer::takeToken(Port& port) {
+    if (maxRate <= 0.0) {
+        return true;
+    }
+    auto now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - port.refilledAt).count();
+    port.tokens = min(max(1.0, maxRate), port.tokens + elapsed * maxRate);
+    port.refilledAt = now;
+    if (port.tokens < 1.0) {
+        return false;
+    }
+    port.tokens -= 1.0;
+    return true;
+}
+
+void SerialMultiplexer::setWatching(size_t index, bool watching) {
+    epoll_event event = {};
+    event.events = watching ? static_cast<uint32_t>(EPOLLIN) : 0u;
+    event.data.u64 = index;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, ports[index].fd, &event);
+}
+
+// Ждем не дольше, чем до ближайшего переоткрытия порта или снятия ограничения
+int SerialMultiplexer::nextWakeTimeout(int timeoutMs) const {
+    auto now = chrono::steady_clock::now();
+    for (const auto& port : ports) {
+        if (port.fd >= 0 && !port.throttled) {
+            continue;
+        }
+        auto wakeAt = port.fd < 0 ? port.retryAt : port.resumeAt;
+        auto wait = chrono::duration_cast<chrono::milliseconds>(wakeAt - now).count();
+        int untilRetry = static_cast<int>(max<long long>(0, wait));
+        if (timeoutMs < 0 || untilRetry < timeoutMs) {
+            timeoutMs = untilRetry;
+        }
+    }
+    return timeoutMs;
+}
+
+#endif // _WIN32
@@ -0,0 +1,94 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+// Чтение последовательных портов для lab_4 и lab_5 (POSIX).
+// Порт открывается один раз и настраивается через termios, все порты
+// обслуживает один цикл epoll, строки нарезаются из кольцевого буфера.
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Кольцевой буфер байтов порта, из которого извлекаются строки по '\n'
+class LineBuffer {
+public:
+    explicit LineBuffer(size_t capacity = 4096);
+
+    // Читает из fd в свободное место буфера; результат как у read()
+    long readFrom(int fd);
+    // Есть ли в буфере полная строка (ее не извлекает, но пропускает конец выброшенной длинной строки)
+    bool hasLine();
+    // Извлекает очередную полную строку без "\r\n"; false, если строки еще нет
+    bool nextLine(std::string& line);
+    void clear();
+    // Сколько байтов выброшено из-за строк длиннее буфера
+    size_t droppedBytes() const { return dropped; }
+
+private:
+    std::vector<char> data;
+    size_t head;        // Начало непрочитанных данных
+    size_t count;       // Сколько байтов в буфере
+    size_t scanned;     // Сколько байтов от head уже проверено на '\n'
+    bool discarding;    // Пропускаем хвост слишком длинной строки
+    size_t dropped;
+};
+
+class SerialMultiplexer {
+public:
+    typedef std::function<void(size_t port, const std::string& line)> LineHandler;
+
+    explicit SerialMultiplexer(int baudRate = 9600,
+                               std::chrono::milliseconds reconnectDelay = std::chrono::milliseconds(1000));
+    ~SerialMultiplexer();
+
+    SerialMultiplexer(const SerialMultiplexer&) = delete;
+    SerialMultiplexer& operator=(const SerialMultiplexer&) = delete;
+
+    // Добавляет порт и сразу пытается его открыть; возвращает номер порта
+    size_t addPort(const std::string& path);
+    bool isOpen(size_t port) const;
+    // Ограничение строк в секунду на порт (0 - без ограничения). Лишние строки
+    // не выбрасываются: порт перестает читаться, пока не накопится квота,
+    // и данные ждут в буфере ядра (обратное давление на устройство)
+    void setMaxRate(double linesPerSecond);
+
+    // Один проход цикла: ждет данных не дольше timeoutMs (-1 - без ограничения)
+    // и вызывает onLine для каждой полной строки. Закрытые порты переоткрывает.
+    void poll(int timeoutMs, const LineHandler& onLine);
+    // Прерывает ожидание в poll() из другого потока
+    void wakeup();
+
+private:
+    struct Port {
+        std::string path;
+        int fd;
+        LineBuffer buffer;
+        std::chrono::steady_clock::time_point retryAt;
+        double tokens;                                  // Квота строк для ограничения частоты
+        std::chrono::steady_clock::time_point refilledAt;
+        bool throttled;                                 // Чтение приостановлено до resumeAt
+        std::chrono::steady_clock::time_point resumeAt;
+    };
+
+    int baudRate;
+    double maxRate;
+    std::chrono::milliseconds reconnectDelay;
+    int epollFd;
+    int wakeFd;
+    std::vector<Port> ports;
+
+    void openPort(size_t index);
+    void closePort(size_t index);
+    void readPort(size_t index, const LineHandler& onLine);
+    void deliverLines(size_t index, const LineHandler& onLine);
+    bool takeToken(Port& port);
+    void setWatching(size_t index, bool watching);
+    int nextWakeTimeout(int timeoutMs) const;
+};
+
+#endif // _WIN32
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,126 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+// Потоковая статистика по окнам времени для lab_4 и lab_5.
+// Каждое показание обрабатывается за O(1), память не зависит от числа показаний.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// count/sum/min/max и дисперсия по Уэлфорду; сводки можно объединять
+struct WindowSummary {
+    size_t count;
+    double sum;
+    double min;
+    double max;
+    double mean;
+    double m2;      // Сумма квадратов отклонений от среднего
+
+    WindowSummary() : count(0), sum(0.0), min(0.0), max(0.0), mean(0.0), m2(0.0) {}
+
+    void add(double value) {
+        if (count == 0 || value < min) min = value;
+        if (count == 0 || value > max) max = value;
+        ++count;
+        sum += value;
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    // Объединение двух сводок (формула Чана)
+    void merge(const WindowSummary& other) {
+        if (other.count == 0) {
+            return;
+        }
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        size_t total = count + other.count;
+        double delta = other.mean - mean;
+        m2 += other.m2 + delta * delta * count * other.count / total;
+        mean += delta * other.count / total;
+        count = total;
+        sum += other.sum;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+
+    double average() const { return count ? mean : 0.0; }
+    // Дисперсия по выборке; для одного показания 0
+    double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+};
+
+// Неперекрывающиеся окна фиксированной ширины, выровненные по эпохе.
+// Окно закрывается первым показанием следующего окна.
+class TumblingWindow {
+public:
+    explicit TumblingWindow(int64_t widthMs) : widthMs(widthMs), startMs(0) {}
+
+    // true, если показание закрыло предыдущее окно: его сводка в closed,
+    // начало - в closedStartMs
+    bool add(int64_t timeMs, double value, WindowSummary& closed, int64_t& closedStartMs) {
+        int64_t windowStart = timeMs - timeMs % widthMs;
+        bool rolled = false;
+        if (current.count > 0 && windowStart != startMs) {
+            closed = current;
+            closedStartMs = startMs;
+            current = WindowSummary();
+            rolled = true;
+        }
+        startMs = windowStart;
+        current.add(value);
+        return rolled;
+    }
+
+    const WindowSummary& summary() const { return current; }
+
+private:
+    int64_t widthMs;
+    int64_t startMs;
+    WindowSummary current;
+};
+
+// Скользящее окно из фиксированного числа корзин: показание попадает в корзину
+// за O(1), сводка собирается из корзин моложе widthMs. Граница окна сдвигается
+// с шагом в одну корзину (widthMs / buckets).
+class SlidingWindow {
+public:
+    explicit SlidingWindow(int64_t widthMs, size_t buckets = 60)
+        : bucketMs(widthMs >= static_cast<int64_t>(buckets) ? widthMs / static_cast<int64_t>(buckets) : 1),
+          slots(buckets), starts(buckets, INT64_MIN) {}
+
+    void add(int64_t timeMs, double value) {
+        int64_t start = timeMs - timeMs % bucketMs;
+        size_t slot = static_cast<size_t>((start / bucketMs) % static_cast<int64_t>(slots.size()));
+        if (starts[slot] != start) {
+            // Корзина осталась от прошлого круга: переиспользуем ее
+            slots[slot] = WindowSummary();
+            starts[slot] = start;
+        }
+        slots[slot].add(value);
+    }
+
+    // Сводка за последние widthMs на момент nowMs
+    WindowSummary summary(int64_t nowMs) const {
+        int64_t oldest = nowMs - nowMs % bucketMs - bucketMs * static_cast<int64_t>(slots.size() - 1);
+        WindowSummary result;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (starts[i] >= oldest && starts[i] <= nowMs) {
+                result.merge(slots[i]);
+            }
+        }
+        return result;
+    }
+
+private:
+    int64_t bucketMs;
+    std::vector<WindowSummary> slots;
+    std::vector<int64_t> starts;
+};
+
+#endif // WINDOW_STATS_H
@@ -0,0 +1,62 @@
+#include "launch_lib.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Spawns/sec of "true" for every spawn mode from a parent with a large RSS.
+// Usage: ./bench_spawn [rss_mb=1024] [spawns=200]
+static void bench(const char* name, int spawns, const LaunchOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    for (int i = 0; i < spawns; ++i) {
+        if (launch_program("true", options) != 0) {
+            ++failed;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << static_cast<long>(spawns / seconds) << " spawns/sec, "
+              << seconds * 1e6 / spawns << " us/spawn";
+    if (failed > 0) {
+        std::cout << " (" << failed << " failed)";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rss_mb = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1024;
+    int spawns = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    // Touch every page so the memory is really resident
+    std::vector<char> ballast(rss_mb * 1024 * 1024);
+    std::memset(ballast.data(), 1, ballast.size());
+    std::cout << "Parent RSS: ~" << rss_mb << " MB, " << spawns << " spawns per mode" << std::endl;
+
+    const struct {
+        const char* name;
+        SpawnMode mode;
+        bool use_shell;
+        bool limited;       // A limit makes PosixSpawn go through clone(CLONE_VM|CLONE_VFORK)
+    } modes[] = {
+        {"fork + sh -c      ", SpawnMode::Fork, true, false},
+        {"fork + exec       ", SpawnMode::Fork, false, false},
+        {"posix_spawn + sh  ", SpawnMode::PosixSpawn, true, false},
+        {"posix_spawn + exec", SpawnMode::PosixSpawn, false, false},
+        {"clone + limits    ", SpawnMode::PosixSpawn, false, true},
+    };
+    for (const auto& mode : modes) {
+        LaunchOptions options;
+        options.spawn_mode = mode.mode;
+        options.use_shell = mode.use_shell;
+        if (mode.limited) {
+            options.cpu_time_limit = 60;
+        }
+        bench(mode.name, spawns, options);
+    }
+
+    // Keeps the ballast alive (and the memset) until the end
+    volatile char last = ballast.empty() ? 0 : ballast.back();
+    (void)last;
+    return 0;
+}
@@ -1,34 +1,198 @@
 #include "launch_lib.h"
+#include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
+#include <sstream>
+#include <thread>
 
-int launch_program(const char* command, bool wait_for_exit) {
 #ifdef _WIN32
-    // Windows implementation
+#include <io.h>
+#include <mutex>
+#else
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+extern char** environ;
+#endif
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool cancel_requested(const LaunchOptions& options) {
+    return options.cancel && options.cancel->load();
+}
+
+#ifdef _WIN32
+// Windows implementation
+
+// Handles for the child's stdout/stderr; NULL means the parent's own
+struct ChildHandles {
+    HANDLE out = NULL;
+    HANDLE err = NULL;
+};
+
+static void close_handles(ChildHandles& handles) {
+    if (handles.out) {
+        CloseHandle(handles.out);
+    }
+    if (handles.err) {
+        CloseHandle(handles.err);
+    }
+    handles = ChildHandles();
+}
+
+// Inheritable duplicate of a CRT descriptor
+static HANDLE inheritable_handle(int fd) {
+    HANDLE original = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    HANDLE duplicate = NULL;
+    if (original == INVALID_HANDLE_VALUE ||
+        !DuplicateHandle(GetCurrentProcess(), original, GetCurrentProcess(), &duplicate, 0, TRUE,
+                         DUPLICATE_SAME_ACCESS)) {
+        std::cerr << "Invalid output descriptor: " << fd << std::endl;
+        return NULL;
+    }
+    return duplicate;
+}
+
+// Child ends for options.stdout_fd/stderr_fd, and with capture = true pipes for the
+// captured streams: their read ends go to readers[0] (stdout) and readers[1] (stderr)
+static bool child_handles(const LaunchOptions& options, bool capture, ChildHandles& handles, HANDLE readers[2]) {
+    HANDLE* child_ends[2] = {&handles.out, &handles.err};
+    int fds[2] = {options.stdout_fd, options.stderr_fd};
+    std::string* buffers[2] = {options.stdout_buffer, options.stderr_buffer};
+
+    readers[0] = readers[1] = NULL;
+    for (int i = 0; i < 2; ++i) {
+        bool opened = true;
+        if (fds[i] >= 0) {
+            *child_ends[i] = inheritable_handle(fds[i]);
+            opened = *child_ends[i] != NULL;
+        } else if (capture && (buffers[i] || options.output_callback)) {
+            SECURITY_ATTRIBUTES sa = {sizeof(sa), NULL, TRUE};
+            opened = CreatePipe(&readers[i], child_ends[i], &sa, 0) != 0;
+            if (opened) {
+                SetHandleInformation(readers[i], HANDLE_FLAG_INHERIT, 0);
+            } else {
+                std::cerr << "CreatePipe failed: " << GetLastError() << std::endl;
+                readers[i] = NULL;
+            }
+        }
+        if (!opened) {
+            close_handles(handles);
+            for (int j = 0; j < i; ++j) {
+                if (readers[j]) {
+                    CloseHandle(readers[j]);
+                    readers[j] = NULL;
+                }
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool start_process(const std::string& command_line, PROCESS_INFORMATION& pi,
+                          const ChildHandles& handles = ChildHandles(), DWORD creation_flags = 0) {
     STARTUPINFO si;
-    PROCESS_INFORMATION pi;
 
     ZeroMemory(&si, sizeof(si));
     si.cb = sizeof(si);
     ZeroMemory(&pi, sizeof(pi));
 
+    bool redirected = handles.out || handles.err;
+    if (redirected) {
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = handles.out ? handles.out : GetStdHandle(STD_OUTPUT_HANDLE);
+        si.hStdError = handles.err ? handles.err : GetStdHandle(STD_ERROR_HANDLE);
+    }
+
     // Convert command to non-const string
-    char* cmd = _strdup(command);
+    char* cmd = _strdup(command_line.c_str());
     if (!cmd) {
         std::cerr << "Memory allocation failed!" << std::endl;
-        return -1;
+        return false;
     }
 
-    if (!CreateProcess(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+    if (!CreateProcess(NULL, cmd, NULL, NULL, redirected, creation_flags, NULL, NULL, &si, &pi)) {
         std::cerr << "CreateProcess failed: " << GetLastError() << std::endl;
         free(cmd);
-        return -1;
+        return false;
     }
 
     free(cmd);
+    return true;
+}
 
-    if (wait_for_exit) {
+// Job object whose processes are all terminated when it is closed; NULL if it can't be created
+static HANDLE create_kill_job() {
+    HANDLE job = CreateJobObject(NULL, NULL);
+    if (job) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+        ZeroMemory(&limits, sizeof(limits));
+        limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+    }
+    return job;
+}
+
+// With a job the child is added to it before it runs (CREATE_SUSPENDED), so nothing
+// it starts escapes: terminating the job stops the whole tree, like a process group
+static bool start_in_job(const std::string& command_line, PROCESS_INFORMATION& pi, const ChildHandles& handles,
+                         HANDLE job) {
+    if (!start_process(command_line, pi, handles, job ? CREATE_SUSPENDED : 0)) {
+        return false;
+    }
+    if (job) {
+        AssignProcessToJobObject(job, pi.hProcess);
+        ResumeThread(pi.hThread);
+    }
+    return true;
+}
+
+static bool start_redirected(const std::string& command_line, const LaunchOptions& options,
+                             PROCESS_INFORMATION& pi, HANDLE job = NULL) {
+    ChildHandles handles;
+    HANDLE readers[2];
+    if (!child_handles(options, false, handles, readers)) {
+        return false;
+    }
+    bool started = start_in_job(command_line, pi, handles, job);
+    close_handles(handles);
+    return started;
+}
+
+static LaunchResult create_and_wait(const std::string& command_line, const LaunchOptions& options);
+
+static int create_process(const std::string& command_line, const LaunchOptions& options) {
+    if (options.wait_for_exit && (options.timeout_ms > 0 || options.cancel)) {
+        // The same wait as launch_and_wait (job object, deadline), with nothing captured
+        LaunchOptions uncaptured = options;
+        uncaptured.stdout_buffer = nullptr;
+        uncaptured.stderr_buffer = nullptr;
+        uncaptured.output_callback = nullptr;
+        return create_and_wait(command_line, uncaptured).exit_code;
+    }
+
+    PROCESS_INFORMATION pi;
+    if (!start_redirected(command_line, options, pi)) {
+        return -1;
+    }
+
+    if (options.wait_for_exit) {
         WaitForSingleObject(pi.hProcess, INFINITE);
         DWORD exit_code;
         GetExitCodeProcess(pi.hProcess, &exit_code);
@@ -40,30 +204,1222 @@ int launch_program(const char* command, bool wait_for_exit) {
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
     return 0;
+}
+
+static double filetime_seconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart / 1e7;  // 100 ns ticks
+}
+
+// Exit code and CPU times of a process that has exited
+static void set_exit_status(LaunchResult& result, HANDLE process) {
+    DWORD exit_code;
+    if (GetExitCodeProcess(process, &exit_code)) {
+        result.exit_code = static_cast<int>(exit_code);
+    }
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(process, &created, &exited, &kernel, &user)) {
+        result.user_seconds = filetime_seconds(user);
+        result.system_seconds = filetime_seconds(kernel);
+    }
+}
+
+static void read_pipe(HANDLE pipe, std::string* buffer, bool is_stderr, const LaunchOptions& options,
+                      std::mutex& callback_mutex) {
+    std::vector<char> chunk(64 * 1024);
+    DWORD size;
+    while (ReadFile(pipe, chunk.data(), static_cast<DWORD>(chunk.size()), &size, NULL) && size > 0) {
+        if (buffer) {
+            buffer->append(chunk.data(), size);
+        }
+        if (options.output_callback) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            options.output_callback(chunk.data(), size, is_stderr);
+        }
+    }
+    CloseHandle(pipe);
+}
+
+static const DWORD kCancelCheckMs = 20;
+
+// Milliseconds to wait before the next deadline or cancel check
+static DWORD wait_slice(std::chrono::steady_clock::time_point deadline, const LaunchOptions& options) {
+    DWORD slice = INFINITE;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count() + 1;
+        slice = left > 0 ? static_cast<DWORD>(left) : 0;
+    }
+    if (options.cancel && slice > kCancelCheckMs) {
+        slice = kCancelCheckMs;
+    }
+    return slice;
+}
+
+static std::chrono::steady_clock::time_point deadline_of(const LaunchOptions& options,
+                                                        std::chrono::steady_clock::time_point started) {
+    return options.timeout_ms > 0 ? started + std::chrono::milliseconds(options.timeout_ms)
+                                  : std::chrono::steady_clock::time_point::max();
+}
+
+static LaunchResult create_and_wait(const std::string& command_line, const LaunchOptions& options) {
+    LaunchResult result;
+    if (cancel_requested(options)) {
+        result.cancelled = true;
+        return result;
+    }
+    ChildHandles handles;
+    HANDLE readers[2];
+    if (!child_handles(options, true, handles, readers)) {
+        return result;
+    }
+
+    // With a deadline the child runs in a job object, so a timeout stops its whole tree
+    bool stoppable = options.timeout_ms > 0 || options.cancel;
+    HANDLE job = stoppable ? create_kill_job() : NULL;
+
+    auto started = std::chrono::steady_clock::now();
+    PROCESS_INFORMATION pi;
+    bool created = start_in_job(command_line, pi, handles, job);
+    // Pipe write ends belong to the child now: EOF comes when it exits
+    close_handles(handles);
+    if (!created) {
+        for (HANDLE reader : readers) {
+            if (reader) {
+                CloseHandle(reader);
+            }
+        }
+        if (job) {
+            CloseHandle(job);
+        }
+        return result;
+    }
+    CloseHandle(pi.hThread);
+
+    // Anonymous pipes can't be waited on together: each captured stream gets its own thread
+    std::mutex callback_mutex;
+    std::thread reader_threads[2];
+    std::string* buffers[2] = {options.stdout_buffer, options.stderr_buffer};
+    for (int i = 0; i < 2; ++i) {
+        if (readers[i]) {
+            reader_threads[i] = std::thread(read_pipe, readers[i], buffers[i], i == 1, std::cref(options),
+                                             std::ref(callback_mutex));
+        }
+    }
+
+    auto deadline = deadline_of(options, started);
+    while (WaitForSingleObject(pi.hProcess, wait_slice(deadline, options)) == WAIT_TIMEOUT) {
+        bool expired = std::chrono::steady_clock::now() >= deadline;
+        if (expired || cancel_requested(options)) {
+            result.timed_out = expired;
+            result.cancelled = !expired;
+            if (job) {
+                TerminateJobObject(job, 1);
+            } else {
+                TerminateProcess(pi.hProcess, 1);
+            }
+            WaitForSingleObject(pi.hProcess, INFINITE);
+            break;
+        }
+    }
+    if (job) {
+        // KILL_ON_JOB_CLOSE: whatever the child left running dies here and releases the pipes
+        CloseHandle(job);
+    }
+    for (std::thread& reader : reader_threads) {
+        if (reader.joinable()) {
+            reader.join();
+        }
+    }
+
+    result.wall_seconds = seconds_since(started);
+    set_exit_status(result, pi.hProcess);
+    CloseHandle(pi.hProcess);
+    return result;
+}
+
+static std::string command_line_of(const std::vector<std::string>& argv) {
+    std::string command_line;
+    for (const std::string& arg : argv) {
+        if (!command_line.empty()) {
+            command_line += ' ';
+        }
+        if (arg.find_first_of(" \t") != std::string::npos) {
+            command_line += '"' + arg + '"';
+        } else {
+            command_line += arg;
+        }
+    }
+    return command_line;
+}
 
 #else
-    // Unix implementation
-    pid_t child_pid = fork();
+// Unix implementation
+
+// What the child needs before exec: redirected stdout/stderr and resource limits
+struct ChildSetup {
+    int stdout_fd = -1;             // -1: inherited from the parent
+    int stderr_fd = -1;
+    rlim_t address_space_limit = 0; // RLIMIT_AS, 0: not set
+    rlim_t cpu_time_limit = 0;
+    int nice_value = 0;
+    int io_priority = 0;            // Value for ioprio_set, 0: inherited
+    bool set_affinity = false;
+    cpu_set_t affinity;
+    std::string cgroup_path;        // The child's own sub-cgroup, empty: none
+    std::string cgroup_procs;       // cgroup_path + "/cgroup.procs", built before the child starts
+    bool new_process_group = false; // The child leads its own group, so a timeout can kill the whole tree
+
+    // posix_spawn can only redirect; anything else needs code in the child
+    bool needs_child_code() const {
+        return address_space_limit != 0 || cpu_time_limit != 0 || nice_value != 0 || io_priority != 0 ||
+               set_affinity || !cgroup_path.empty();
+    }
+};
+
+static const int kIoprioClassShift = 13;
+static const int kIoprioWhoProcess = 1;
+static const size_t kCloneStackSize = 256 * 1024;
+
+static bool write_file(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    bool written = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return written;
+}
+
+// Value of "key value" line (key empty: the first number in the file), -1 if missing
+static long long read_cgroup_value(const std::string& path, const std::string& key) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    char text[4096];
+    ssize_t size = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (size <= 0) {
+        return -1;
+    }
+    text[size] = '\0';
+
+    std::istringstream lines(text);
+    std::string name;
+    long long value;
+    if (key.empty()) {
+        return lines >> value ? value : -1;
+    }
+    while (lines >> name >> value) {
+        if (name == key) {
+            return value;
+        }
+    }
+    return -1;
+}
+
+// Sub-cgroup for one child: one per child, so its counters cover exactly that
+// child and the processes it starts
+static bool create_cgroup(const LaunchOptions& options, ChildSetup& setup) {
+    static std::atomic<unsigned> counter(0);
+    std::string path = options.cgroup_parent + "/launch-" + std::to_string(getpid()) + "-" +
+                       std::to_string(counter.fetch_add(1));
+    if (mkdir(path.c_str(), 0755) == -1) {
+        std::cerr << "Failed to create cgroup " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    // memory.max exists only if the memory controller is enabled in the parent's cgroup.subtree_control.
+    // RLIMIT_AS isn't set with a cgroup, so without memory.max the child would run unlimited: fail instead.
+    if (options.memory_limit != 0 && !write_file(path + "/memory.max", std::to_string(options.memory_limit))) {
+        std::cerr << "Failed to set memory.max in " << path << ": " << strerror(errno) << std::endl;
+        rmdir(path.c_str());
+        return false;
+    }
+    setup.cgroup_path = path;
+    setup.cgroup_procs = path + "/cgroup.procs";
+    return true;
+}
+
+// Reads the accounting of an exited child's cgroup and removes the cgroup
+static void release_cgroup(const std::string& path, LaunchResult* result) {
+    if (path.empty()) {
+        return;
+    }
+    if (result) {
+        long long usage_usec = read_cgroup_value(path + "/cpu.stat", "usage_usec");
+        if (usage_usec >= 0) {
+            result->cgroup_cpu_seconds = usage_usec / 1e6;
+        }
+        long long peak = read_cgroup_value(path + "/memory.peak", "");
+        if (peak >= 0) {
+            result->cgroup_memory_peak_kb = peak / 1024;
+        }
+    }
+    // Fails with EBUSY while something the child started is still alive; the cgroup stays then
+    rmdir(path.c_str());
+}
+
+static bool child_setup(const LaunchOptions& options, ChildSetup& setup) {
+    setup.stdout_fd = options.stdout_fd;
+    setup.stderr_fd = options.stderr_fd;
+    // With a cgroup memory_limit is memory.max only: RLIMIT_AS counts reserved
+    // address space, not memory, and would fail programs that reserve a lot
+    setup.address_space_limit = options.address_space_limit != 0 ? options.address_space_limit
+                              : options.cgroup_parent.empty() ? options.memory_limit : 0;
+    setup.cpu_time_limit = options.cpu_time_limit > 0 ? options.cpu_time_limit : 0;
+    setup.nice_value = options.nice_value;
+    setup.new_process_group = options.timeout_ms > 0 || options.cancel != nullptr;
+    if (options.io_class > 0) {
+        setup.io_priority = (options.io_class << kIoprioClassShift) | options.io_level;
+    }
+    if (!options.cpu_affinity.empty()) {
+        // A CPU that doesn't exist is an error, not an empty mask the child fails on
+        long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+        setup.set_affinity = true;
+        CPU_ZERO(&setup.affinity);
+        for (int cpu : options.cpu_affinity) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE || (cpu_count > 0 && cpu >= cpu_count)) {
+                std::cerr << "Invalid CPU in cpu_affinity: " << cpu << std::endl;
+                return false;
+            }
+            CPU_SET(cpu, &setup.affinity);
+        }
+    }
+    if (!options.cgroup_parent.empty()) {
+        return create_cgroup(options, setup);
+    }
+    return true;
+}
+
+static double timeval_seconds(const timeval& time) {
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+static void set_exit_status(LaunchResult& result, int status, const rusage& usage) {
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.term_signal = WTERMSIG(status);
+    }
+    result.user_seconds = timeval_seconds(usage.ru_utime);
+    result.system_seconds = timeval_seconds(usage.ru_stime);
+    result.max_rss_kb = usage.ru_maxrss;
+}
+
+static int wait_child(pid_t child_pid) {
+    int status;
+    while (waitpid(child_pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return -1;
+}
+
+// Makes fd the child's descriptor target
+static int redirect_in_child(int fd, int target) {
+    if (fd < 0) {
+        return 0;
+    }
+    if (fd == target) {
+        return fcntl(fd, F_SETFD, 0);  // Keep it open across exec
+    }
+    return dup2(fd, target) == -1 ? -1 : 0;
+}
+
+// Runs in the child between fork/clone and exec: only system calls, no allocation.
+// Returns 0 or the errno of the step that failed.
+static int prepare_child(const ChildSetup& setup) {
+    if (setup.new_process_group && setpgid(0, 0) == -1) {
+        return errno;
+    }
+    if (!setup.cgroup_procs.empty()) {
+        // Moves the child before it runs anything, so every process it starts is counted
+        char pid_text[16];
+        int length = 0;
+        char digits[16];
+        int digit_count = 0;
+        for (long pid = static_cast<long>(syscall(SYS_getpid)); pid > 0; pid /= 10) {
+            digits[digit_count++] = static_cast<char>('0' + pid % 10);
+        }
+        while (digit_count > 0) {
+            pid_text[length++] = digits[--digit_count];
+        }
+        int fd = open(setup.cgroup_procs.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return errno;
+        }
+        ssize_t written = write(fd, pid_text, length);
+        int error = errno;
+        close(fd);
+        if (written != length) {
+            return error;
+        }
+    }
+    if (redirect_in_child(setup.stdout_fd, STDOUT_FILENO) == -1 ||
+        redirect_in_child(setup.stderr_fd, STDERR_FILENO) == -1) {
+        return errno;
+    }
+    if (setup.address_space_limit != 0) {
+        rlimit limit = {setup.address_space_limit, setup.address_space_limit};
+        if (setrlimit(RLIMIT_AS, &limit) == -1) {
+            return errno;
+        }
+    }
+    if (setup.cpu_time_limit != 0) {
+        // SIGXCPU at the soft limit, SIGKILL a second later if it is ignored
+        rlimit limit = {setup.cpu_time_limit, setup.cpu_time_limit + 1};
+        if (setrlimit(RLIMIT_CPU, &limit) == -1) {
+            return errno;
+        }
+    }
+    if (setup.nice_value != 0 && setpriority(PRIO_PROCESS, 0, setup.nice_value) == -1) {
+        return errno;
+    }
+    if (setup.io_priority != 0 && syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, setup.io_priority) == -1) {
+        return errno;
+    }
+    if (setup.set_affinity && sched_setaffinity(0, sizeof(setup.affinity), &setup.affinity) == -1) {
+        return errno;
+    }
+    return 0;
+}
+
+// Why the child didn't run the program; the parent reports it and returns -1 in both spawn modes
+struct ChildFailure {
+    int error;          // errno, 0: exec succeeded
+    bool in_setup;      // prepare_child failed, exec wasn't tried
+};
+
+static void report_child_failure(const ChildFailure& failure) {
+    std::cerr << (failure.in_setup ? "Child setup failed: " : "Exec failed: ") << strerror(failure.error)
+              << std::endl;
+}
+
+static void exec_child(char* const* argv, bool search_path) {
+    if (search_path) {
+        execvp(argv[0], argv);
+    } else {
+        execv(argv[0], argv);
+    }
+}
+
+// prepare_child and exec; returns only if one of them failed
+static ChildFailure run_child(char* const* argv, bool search_path, const ChildSetup& setup) {
+    ChildFailure failure = {prepare_child(setup), true};
+    if (failure.error == 0) {
+        exec_child(argv, search_path);
+        failure = {errno, false};
+    }
+    return failure;
+}
+
+struct CloneRequest {
+    char* const* argv;
+    bool search_path;
+    const ChildSetup* setup;
+    const sigset_t* parent_mask;
+    ChildFailure failure;   // Written by the child: the parent is suspended until exec or _exit
+};
+
+// The child shares the parent's memory until exec (CLONE_VM | CLONE_VFORK), like posix_spawn does
+static int clone_child(void* arg) {
+    CloneRequest* request = static_cast<CloneRequest*>(arg);
+
+    // The parent's signal handlers must not run on its memory: back to defaults
+    for (int sig = 1; sig < NSIG; ++sig) {
+        struct sigaction action;
+        if (sigaction(sig, NULL, &action) == 0 && action.sa_handler != SIG_IGN && action.sa_handler != SIG_DFL) {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigemptyset(&action.sa_mask);
+            sigaction(sig, &action, NULL);
+        }
+    }
+    sigprocmask(SIG_SETMASK, request->parent_mask, NULL);
+
+    request->failure = run_child(request->argv, request->search_path, *request->setup);
+    _exit(127);
+}
+
+static pid_t clone_process(char* const* argv, bool search_path, const ChildSetup& setup) {
+    std::vector<char> stack(kCloneStackSize);
+    sigset_t all_signals, parent_mask;
+    sigfillset(&all_signals);
+    // Nothing may interrupt the child while it runs on the parent's memory
+    pthread_sigmask(SIG_BLOCK, &all_signals, &parent_mask);
+
+    CloneRequest request = {argv, search_path, &setup, &parent_mask, {0, false}};
+    pid_t child_pid = clone(clone_child, stack.data() + stack.size(), CLONE_VM | CLONE_VFORK | SIGCHLD, &request);
+    int clone_errno = errno;
+    pthread_sigmask(SIG_SETMASK, &parent_mask, NULL);
 
+    if (child_pid == -1) {
+        std::cerr << "Clone failed: " << strerror(clone_errno) << std::endl;
+        return -1;
+    }
+    if (request.failure.error != 0) {
+        wait_child(child_pid);
+        report_child_failure(request.failure);
+        return -1;
+    }
+    return child_pid;
+}
+
+// argv must be NULL-terminated. search_path selects execvp/posix_spawnp.
+// Returns the child's pid or -1.
+static pid_t start_process(char* const* argv, bool search_path, SpawnMode spawn_mode, const ChildSetup& setup) {
+    pid_t child_pid;
+
+    if (spawn_mode == SpawnMode::PosixSpawn && setup.needs_child_code()) {
+        return clone_process(argv, search_path, setup);
+    }
+
+    if (spawn_mode == SpawnMode::PosixSpawn) {
+        posix_spawnattr_t attributes;
+        posix_spawnattr_t* spawn_attributes = NULL;
+        if (setup.new_process_group) {
+            posix_spawnattr_init(&attributes);
+            posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+            posix_spawnattr_setpgroup(&attributes, 0);
+            spawn_attributes = &attributes;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_t* file_actions = NULL;
+        if (setup.stdout_fd >= 0 || setup.stderr_fd >= 0) {
+            posix_spawn_file_actions_init(&actions);
+            if (setup.stdout_fd >= 0) {
+                posix_spawn_file_actions_adddup2(&actions, setup.stdout_fd, STDOUT_FILENO);
+            }
+            if (setup.stderr_fd >= 0) {
+                posix_spawn_file_actions_adddup2(&actions, setup.stderr_fd, STDERR_FILENO);
+            }
+            file_actions = &actions;
+        }
+
+        int error = search_path
+            ? posix_spawnp(&child_pid, argv[0], file_actions, spawn_attributes, argv, environ)
+            : posix_spawn(&child_pid, argv[0], file_actions, spawn_attributes, argv, environ);
+        if (file_actions) {
+            posix_spawn_file_actions_destroy(file_actions);
+        }
+        if (spawn_attributes) {
+            posix_spawnattr_destroy(spawn_attributes);
+        }
+        if (error != 0) {
+            std::cerr << "posix_spawn failed: " << strerror(error) << std::endl;
+            return -1;
+        }
+        return child_pid;
+    }
+
+    // The child reports a failure through this pipe; exec closes it (O_CLOEXEC),
+    // so EOF without data means the program is running
+    int report[2];
+    if (pipe2(report, O_CLOEXEC) == -1) {
+        std::cerr << "Pipe failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    child_pid = fork();
     if (child_pid == -1) {
         std::cerr << "Fork failed!" << std::endl;
+        close(report[0]);
+        close(report[1]);
         return -1;
     } else if (child_pid == 0) {
-        // Child process
-        execl("/bin/sh", "sh", "-c", command, NULL);
-        std::cerr << "Exec failed!" << std::endl;
-        exit(EXIT_FAILURE);
+        // Child process: argv and setup were built before fork(), nothing is allocated here
+        ChildFailure failure = run_child(argv, search_path, setup);
+        ssize_t ignored = write(report[1], &failure, sizeof(failure));
+        (void)ignored;
+        _exit(127);
+    }
+    if (setup.new_process_group) {
+        // Also from the parent: a signal sent right after fork() must reach the group
+        setpgid(child_pid, child_pid);
+    }
+    close(report[1]);
+    ChildFailure failure;
+    ssize_t size;
+    while ((size = read(report[0], &failure, sizeof(failure))) == -1 && errno == EINTR) {
+    }
+    close(report[0]);
+    if (size == static_cast<ssize_t>(sizeof(failure))) {
+        wait_child(child_pid);
+        report_child_failure(failure);
+        return -1;
+    }
+    return child_pid;
+}
+
+static pid_t start_argv(const std::vector<std::string>& args, bool search_path, SpawnMode spawn_mode,
+                        const ChildSetup& setup) {
+    if (args.empty()) {
+        std::cerr << "Empty command!" << std::endl;
+        return -1;
+    }
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(NULL);
+    return start_process(argv.data(), search_path, spawn_mode, setup);
+}
+
+// "/bin/sh -c command" or the command split on whitespace
+static std::vector<std::string> command_args(const std::string& command, bool use_shell) {
+    if (use_shell) {
+        return {"/bin/sh", "-c", command};
+    }
+    std::vector<std::string> args;
+    std::istringstream words(command);
+    std::string word;
+    while (words >> word) {
+        args.push_back(word);
+    }
+    return args;
+}
+
+// Read end of a capture pipe
+struct CaptureStream {
+    int fd;                 // -1 once the child closed its end
+    std::string* buffer;
+    bool is_stderr;
+    size_t read_size;       // Pipe capacity: one read() can empty a full pipe
+};
+
+static void close_stream(CaptureStream& stream) {
+    if (stream.fd >= 0) {
+        close(stream.fd);
+        stream.fd = -1;
+    }
+}
+
+// Reads until the pipe is empty. FIONREAD tells how much is waiting, so that much
+// is read straight into the caller's buffer and the callback sees it there:
+// each byte is copied out of the kernel once.
+static void read_available(CaptureStream& stream, const LaunchOptions& options, std::vector<char>& chunk) {
+    while (true) {
+        int available = 0;
+        char* target;
+        size_t old_size = 0;
+        size_t wanted;
+        if (stream.buffer && ioctl(stream.fd, FIONREAD, &available) == 0 && available > 0) {
+            old_size = stream.buffer->size();
+            wanted = static_cast<size_t>(available);
+            stream.buffer->resize(old_size + wanted);
+            target = &(*stream.buffer)[old_size];
+        } else {
+            // Nothing waiting (EOF is next) or no buffer: read into the scratch chunk
+            available = 0;
+            chunk.resize(stream.read_size);
+            target = chunk.data();
+            wanted = chunk.size();
+        }
+
+        ssize_t size = read(stream.fd, target, wanted);
+        int read_errno = errno;
+        if (available > 0) {
+            // Shrinking keeps the storage, target stays valid
+            stream.buffer->resize(old_size + (size > 0 ? static_cast<size_t>(size) : 0));
+        } else if (stream.buffer && size > 0) {
+            stream.buffer->append(target, static_cast<size_t>(size));
+        }
+
+        if (size > 0) {
+            if (options.output_callback) {
+                options.output_callback(target, static_cast<size_t>(size), stream.is_stderr);
+            }
+        } else if (size == 0) {
+            close_stream(stream);  // EOF
+            return;
+        } else if (read_errno == EAGAIN || read_errno == EWOULDBLOCK) {
+            return;
+        } else if (read_errno != EINTR) {
+            std::cerr << "Read failed: " << strerror(read_errno) << std::endl;
+            close_stream(stream);
+            return;
+        }
+    }
+}
+
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+static const int kCancelCheckMs = 20;
+static const int kReapCheckMs = 10;     // Without pidfd exits are checked this often
+
+// SIGTERM to the child's process group at the deadline, SIGKILL kill_grace_ms later
+struct Escalation {
+    std::chrono::steady_clock::time_point deadline;     // max() when there is none
+    int signals_sent = 0;
+};
+
+static Escalation start_escalation(const LaunchOptions& options, std::chrono::steady_clock::time_point started) {
+    Escalation escalation;
+    escalation.deadline = options.timeout_ms > 0
+        ? started + std::chrono::milliseconds(options.timeout_ms)
+        : std::chrono::steady_clock::time_point::max();
+    return escalation;
+}
+
+// Sends the next signal once the deadline passes or cancel is requested.
+// Returns true when even kill_grace_ms after SIGKILL has passed.
+static bool check_deadline(pid_t child_pid, Escalation& escalation, const LaunchOptions& options,
+                           LaunchResult& result) {
+    auto now = std::chrono::steady_clock::now();
+    bool expired = now >= escalation.deadline;
+    if (escalation.signals_sent == 0 && !expired && cancel_requested(options)) {
+        result.cancelled = true;
+    } else if (!expired) {
+        return false;
+    } else if (escalation.signals_sent == 0) {
+        result.timed_out = true;
+    }
+
+    if (escalation.signals_sent == 2) {
+        escalation.deadline = std::chrono::steady_clock::time_point::max();
+        return true;
+    }
+    kill(-child_pid, escalation.signals_sent == 0 ? SIGTERM : SIGKILL);
+    ++escalation.signals_sent;
+    escalation.deadline = now + std::chrono::milliseconds(options.kill_grace_ms);
+    return false;
+}
+
+// After SIGTERM the group still gets SIGKILL when the grace period ends, even if the
+// leader has already exited: members that ignore SIGTERM would outlive it otherwise
+static bool kill_pending(pid_t child_pid, const Escalation& escalation) {
+    return escalation.signals_sent == 1 && (kill(-child_pid, 0) == 0 || errno == EPERM);
+}
+
+// poll() timeout until the next deadline or cancel check, -1 if there is none
+static int poll_timeout(const Escalation& escalation, const LaunchOptions& options) {
+    int timeout = -1;
+    if (escalation.deadline != std::chrono::steady_clock::time_point::max()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            escalation.deadline - std::chrono::steady_clock::now()).count() + 1;
+        timeout = left > 0 ? static_cast<int>(left) : 0;
+    }
+    if (options.cancel && escalation.signals_sent == 0 && (timeout < 0 || timeout > kCancelCheckMs)) {
+        timeout = kCancelCheckMs;
+    }
+    return timeout;
+}
+
+// Reads both streams as data arrives and waits for the child, within the deadline.
+// Neither pipe can fill up while the other one is being waited on, so nothing
+// deadlocks. Returns true if the child was reaped (status and usage are set).
+static bool wait_with_output(pid_t child_pid, CaptureStream (&streams)[2], const LaunchOptions& options,
+                             Escalation& escalation, LaunchResult& result, int& status, rusage& usage) {
+    int pidfd = open_pidfd(child_pid);
+    bool exited = false;
+    bool reaped = false;
+    std::vector<char> chunk;
+
+    while (true) {
+        if (!exited) {
+            pid_t waited = wait4(child_pid, &status, WNOHANG, &usage);
+            if (waited == child_pid) {
+                exited = reaped = true;
+            } else if (waited == -1 && errno != EINTR) {
+                exited = true;
+            }
+        }
+        auto finished = [&] {
+            return exited && streams[0].fd < 0 && streams[1].fd < 0 && !kill_pending(child_pid, escalation);
+        };
+        if (finished()) {
+            break;
+        }
+
+        // The child's exit doesn't end the wait: something it started may still
+        // hold the pipes, and the deadline covers that too
+        if (check_deadline(child_pid, escalation, options, result)) {
+            // SIGKILL didn't close the pipes: a process outside the group holds them
+            for (CaptureStream& stream : streams) {
+                close_stream(stream);
+            }
+        }
+        if (finished()) {
+            break;      // SIGKILL went to what was left of the group, nothing else to wait for
+        }
+
+        pollfd fds[3];
+        CaptureStream* polled[2];
+        nfds_t stream_count = 0;
+        for (CaptureStream& stream : streams) {
+            if (stream.fd >= 0) {
+                fds[stream_count] = {stream.fd, POLLIN, 0};
+                polled[stream_count++] = &stream;
+            }
+        }
+        nfds_t count = stream_count;
+        int timeout = poll_timeout(escalation, options);
+        if (!exited) {
+            if (pidfd >= 0) {
+                fds[count++] = {pidfd, POLLIN, 0};  // Readable when the child exits
+            } else if (timeout < 0 || timeout > kReapCheckMs) {
+                timeout = kReapCheckMs;
+            }
+        } else if (escalation.signals_sent == 1 && (timeout < 0 || timeout > kReapCheckMs)) {
+            timeout = kReapCheckMs;     // Checks whether the rest of the group exited before SIGKILL
+        }
+
+        if (poll(fds, count, timeout) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            for (CaptureStream& stream : streams) {
+                close_stream(stream);
+            }
+            if (pidfd >= 0) {
+                close(pidfd);
+                pidfd = -1;
+            }
+            continue;
+        }
+        for (nfds_t i = 0; i < stream_count; ++i) {
+            if (fds[i].revents != 0) {
+                read_available(*polled[i], options, chunk);
+            }
+        }
+    }
+
+    if (pidfd >= 0) {
+        close(pidfd);
+    }
+    return reaped;
+}
+
+static LaunchResult run_and_wait(const std::vector<std::string>& args, bool search_path,
+                                 const LaunchOptions& options) {
+    LaunchResult result;
+    ChildSetup setup;
+    if (!child_setup(options, setup)) {
+        return result;
+    }
+    CaptureStream streams[2] = {{-1, options.stdout_buffer, false, 0}, {-1, options.stderr_buffer, true, 0}};
+    int* child_ends[2] = {&setup.stdout_fd, &setup.stderr_fd};
+    int pipe_ends[2] = {-1, -1};
+
+    for (int i = 0; i < 2; ++i) {
+        if (*child_ends[i] >= 0 || (!streams[i].buffer && !options.output_callback)) {
+            continue;  // Redirected or not captured
+        }
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) == -1) {
+            std::cerr << "Pipe failed: " << strerror(errno) << std::endl;
+            for (int j = 0; j < i; ++j) {
+                close_stream(streams[j]);
+                if (pipe_ends[j] >= 0) {
+                    close(pipe_ends[j]);
+                }
+            }
+            release_cgroup(setup.cgroup_path, NULL);
+            return result;
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        int capacity = -1;
+#ifdef F_SETPIPE_SZ
+        // Fails above /proc/sys/fs/pipe-max-size; the default capacity stays then
+        fcntl(fds[0], F_SETPIPE_SZ, static_cast<int>(options.pipe_size));
+        capacity = fcntl(fds[0], F_GETPIPE_SZ);
+#endif
+        streams[i].fd = fds[0];
+        streams[i].read_size = capacity > 0 ? static_cast<size_t>(capacity) : 64 * 1024;
+        pipe_ends[i] = fds[1];
+        *child_ends[i] = fds[1];
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    pid_t child_pid = cancel_requested(options) ? -1 : start_argv(args, search_path, options.spawn_mode, setup);
+    result.cancelled = child_pid == -1 && cancel_requested(options);
+    // Write ends belong to the child now: EOF comes when it (and its own children) close them
+    for (int fd : pipe_ends) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (child_pid == -1) {
+        for (CaptureStream& stream : streams) {
+            close_stream(stream);
+        }
+        release_cgroup(setup.cgroup_path, NULL);
+        return result;
+    }
+
+    Escalation escalation = start_escalation(options, started);
+    int status;
+    rusage usage;
+    bool reaped = wait_with_output(child_pid, streams, options, escalation, result, status, usage);
+    result.wall_seconds = seconds_since(started);
+    if (reaped) {
+        set_exit_status(result, status, usage);
+        release_cgroup(setup.cgroup_path, &result);
     } else {
-        // Parent process
-        if (wait_for_exit) {
+        release_cgroup(setup.cgroup_path, NULL);
+    }
+    return result;
+}
+
+// A child nobody waits for (wait_for_exit = false)
+struct BackgroundChild {
+    pid_t pid;
+    int pidfd;                  // -1 without pidfd_open: its exit is checked every kReapCheckMs
+    std::string cgroup_path;
+};
+
+// One thread, started with the first background child, reaps all of them
+struct BackgroundReaper {
+    std::mutex mutex;
+    std::vector<BackgroundChild> added;     // Not yet picked up by the thread
+    int wake_fd = -1;                       // eventfd, written after a child is added
+};
+
+static void reap_background(BackgroundReaper* reaper) {
+    std::vector<BackgroundChild> children;
+    std::vector<pollfd> fds;
+    while (true) {
+        if (reaper->wake_fd >= 0) {
+            uint64_t count;
+            ssize_t ignored = read(reaper->wake_fd, &count, sizeof(count));
+            (void)ignored;
+        }
+        {
+            std::lock_guard<std::mutex> lock(reaper->mutex);
+            children.insert(children.end(), reaper->added.begin(), reaper->added.end());
+            reaper->added.clear();
+        }
+
+        // waitpid() on each exact pid doesn't take exit statuses meant for other waiters
+        for (size_t i = 0; i < children.size();) {
             int status;
-            waitpid(child_pid, &status, 0);
-            if (WIFEXITED(status)) {
-                return WEXITSTATUS(status);
+            pid_t reaped = waitpid(children[i].pid, &status, WNOHANG);
+            if (reaped == 0 || (reaped == -1 && errno == EINTR)) {
+                ++i;
+                continue;
             }
-            return -1;
+            release_cgroup(children[i].cgroup_path, NULL);
+            if (children[i].pidfd >= 0) {
+                close(children[i].pidfd);
+            }
+            children[i] = children.back();
+            children.pop_back();
         }
-        return 0;
+
+        fds.clear();
+        int timeout = reaper->wake_fd >= 0 ? -1 : kReapCheckMs;
+        if (reaper->wake_fd >= 0) {
+            fds.push_back({reaper->wake_fd, POLLIN, 0});
+        }
+        for (const BackgroundChild& child : children) {
+            if (child.pidfd >= 0) {
+                fds.push_back({child.pidfd, POLLIN, 0});
+            } else {
+                timeout = kReapCheckMs;
+            }
+        }
+        if (poll(fds.data(), fds.size(), timeout) == -1 && errno != EINTR) {
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+static void reap_in_background(pid_t child_pid, const std::string& cgroup_path) {
+    // Never destroyed: the thread may still run while static objects are destroyed at exit
+    static BackgroundReaper* reaper = [] {
+        BackgroundReaper* created = new BackgroundReaper();
+        created->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        std::thread(reap_background, created).detach();
+        return created;
+    }();
+    {
+        std::lock_guard<std::mutex> lock(reaper->mutex);
+        reaper->added.push_back({child_pid, open_pidfd(child_pid), cgroup_path});
+    }
+    if (reaper->wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(reaper->wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+static int run_args(const std::vector<std::string>& args, bool search_path, const LaunchOptions& options) {
+    // A deadline or cancel needs the child in its own group, so the whole tree can be
+    // signalled; otherwise it stays in the caller's group and Ctrl-C still reaches it
+    bool stoppable = options.wait_for_exit && (options.timeout_ms > 0 || options.cancel != nullptr);
+    if (stoppable && cancel_requested(options)) {
+        return -1;
+    }
+    ChildSetup setup;
+    if (!child_setup(options, setup)) {
+        return -1;
+    }
+    setup.new_process_group = stoppable;
+    auto started = std::chrono::steady_clock::now();
+    pid_t child_pid = start_argv(args, search_path, options.spawn_mode, setup);
+    if (child_pid == -1) {
+        release_cgroup(setup.cgroup_path, NULL);
+        return -1;
     }
+    if (stoppable) {
+        // The same wait as launch_and_wait, with nothing captured
+        CaptureStream streams[2] = {{-1, NULL, false, 0}, {-1, NULL, true, 0}};
+        Escalation escalation = start_escalation(options, started);
+        LaunchResult result;
+        int status;
+        rusage usage;
+        if (wait_with_output(child_pid, streams, options, escalation, result, status, usage)) {
+            set_exit_status(result, status, usage);
+        }
+        release_cgroup(setup.cgroup_path, NULL);
+        return result.exit_code;
+    }
+    if (options.wait_for_exit) {
+        int exit_code = wait_child(child_pid);
+        release_cgroup(setup.cgroup_path, NULL);
+        return exit_code;
+    }
+    reap_in_background(child_pid, setup.cgroup_path);
+    return 0;
+}
+#endif
+
+int launch_program(const char* command, bool wait_for_exit) {
+    LaunchOptions options;
+    options.wait_for_exit = wait_for_exit;
+    return launch_program(command, options);
+}
+
+int launch_program(const char* command, const LaunchOptions& options) {
+#ifdef _WIN32
+    // CreateProcess never goes through a shell, use_shell and spawn_mode don't apply
+    return create_process(command, options);
+#else
+    return run_args(command_args(command, options.use_shell), !options.use_shell, options);
 #endif
-}
\ No newline at end of file
+}
+
+int launch_program(const std::vector<std::string>& argv, const LaunchOptions& options) {
+#ifdef _WIN32
+    return create_process(command_line_of(argv), options);
+#else
+    return run_args(argv, true, options);
+#endif
+}
+
+LaunchResult launch_and_wait(const char* command, const LaunchOptions& options) {
+#ifdef _WIN32
+    return create_and_wait(command, options);
+#else
+    return run_and_wait(command_args(command, options.use_shell), !options.use_shell, options);
+#endif
+}
+
+LaunchResult launch_and_wait(const std::vector<std::string>& argv, const LaunchOptions& options) {
+#ifdef _WIN32
+    return create_and_wait(command_line_of(argv), options);
+#else
+    return run_and_wait(argv, true, options);
+#endif
+}
+
+std::vector<LaunchResult> launch_batch(const std::vector<std::string>& commands, int max_parallelism,
+                                       const LaunchOptions& options) {
+    std::vector<LaunchResult> results(commands.size());
+    size_t parallelism = max_parallelism > 1 ? static_cast<size_t>(max_parallelism) : 1;
+
+#ifdef _WIN32
+    // WaitForMultipleObjects takes at most MAXIMUM_WAIT_OBJECTS handles
+    if (parallelism > MAXIMUM_WAIT_OBJECTS) {
+        parallelism = MAXIMUM_WAIT_OBJECTS;
+    }
+
+    struct Running {
+        size_t index;
+        HANDLE process;
+        HANDLE job;     // With timeout_ms or cancel: the child's tree, terminated together
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline;
+        bool terminated;
+    };
+    bool stoppable = options.timeout_ms > 0 || options.cancel;
+    std::vector<Running> running;
+    size_t next = 0;
+
+    while (next < commands.size() || !running.empty()) {
+        if (cancel_requested(options)) {
+            for (; next < commands.size(); ++next) {
+                results[next].cancelled = true;
+            }
+        }
+        while (next < commands.size() && running.size() < parallelism) {
+            PROCESS_INFORMATION pi;
+            HANDLE job = stoppable ? create_kill_job() : NULL;
+            auto started = std::chrono::steady_clock::now();
+            if (start_redirected(commands[next], options, pi, job)) {
+                CloseHandle(pi.hThread);
+                running.push_back({next, pi.hProcess, job, started, deadline_of(options, started), false});
+            } else if (job) {
+                CloseHandle(job);
+            }
+            ++next;
+        }
+        if (running.empty()) {
+            continue;
+        }
+
+        std::vector<HANDLE> handles;
+        DWORD slice = INFINITE;
+        auto now = std::chrono::steady_clock::now();
+        bool cancelled = cancel_requested(options);
+        for (Running& child : running) {
+            if (!child.terminated && (now >= child.deadline || cancelled)) {
+                results[child.index].timed_out = now >= child.deadline;
+                results[child.index].cancelled = !results[child.index].timed_out;
+                if (child.job) {
+                    TerminateJobObject(child.job, 1);
+                } else {
+                    TerminateProcess(child.process, 1);
+                }
+                child.deadline = std::chrono::steady_clock::time_point::max();
+                child.terminated = true;
+            }
+            handles.push_back(child.process);
+            DWORD child_slice = wait_slice(child.deadline, options);
+            if (child_slice < slice) {
+                slice = child_slice;
+            }
+        }
+        DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(),
+                                                FALSE, slice);
+        if (signaled == WAIT_TIMEOUT) {
+            continue;
+        }
+        if (signaled >= WAIT_OBJECT_0 + handles.size()) {
+            std::cerr << "WaitForMultipleObjects failed: " << GetLastError() << std::endl;
+            break;
+        }
+
+        Running child = running[signaled - WAIT_OBJECT_0];
+        running.erase(running.begin() + (signaled - WAIT_OBJECT_0));
+        LaunchResult& result = results[child.index];
+        result.wall_seconds = seconds_since(child.started);
+        set_exit_status(result, child.process);
+        CloseHandle(child.process);
+        if (child.job) {
+            // KILL_ON_JOB_CLOSE: whatever the child left running dies with it
+            CloseHandle(child.job);
+        }
+    }
+#else
+    struct Running {
+        size_t index;
+        pid_t pid;
+        int pidfd;  // -1 if pidfd_open is unavailable: then the loop polls every 10 ms
+        std::chrono::steady_clock::time_point started;
+        std::string cgroup_path;
+        Escalation escalation;
+        bool reaped;    // The child has exited, its group may still be waiting for SIGKILL
+    };
+    std::vector<Running> running;
+    size_t next = 0;
+
+    while (next < commands.size() || !running.empty()) {
+        if (cancel_requested(options)) {
+            // Commands that haven't started yet never will
+            for (; next < commands.size(); ++next) {
+                results[next].cancelled = true;
+            }
+        }
+        while (next < commands.size() && running.size() < parallelism) {
+            // Every command gets its own setup: with cgroup_parent, its own cgroup
+            ChildSetup setup;
+            auto started = std::chrono::steady_clock::now();
+            pid_t child_pid = -1;
+            if (child_setup(options, setup)) {
+                child_pid = start_argv(command_args(commands[next], options.use_shell),
+                                       !options.use_shell, options.spawn_mode, setup);
+            }
+            if (child_pid != -1) {
+                running.push_back({next, child_pid, open_pidfd(child_pid), started, setup.cgroup_path,
+                                   start_escalation(options, started), false});
+            } else {
+                release_cgroup(setup.cgroup_path, NULL);
+            }
+            ++next;
+        }
+        if (running.empty()) {
+            continue;
+        }
+
+        // A pidfd becomes readable when its process exits; the timeout is the nearest deadline
+        std::vector<pollfd> fds;
+        int timeout = -1;
+        for (Running& child : running) {
+            check_deadline(child.pid, child.escalation, options, results[child.index]);
+            int child_timeout = poll_timeout(child.escalation, options);
+            if (child.pidfd >= 0) {
+                fds.push_back({child.pidfd, POLLIN, 0});
+            } else if (child_timeout < 0 || child_timeout > kReapCheckMs) {
+                // Also a reaped child whose group waits for SIGKILL: the group may exit first
+                child_timeout = kReapCheckMs;
+            }
+            if (child_timeout >= 0 && (timeout < 0 || child_timeout < timeout)) {
+                timeout = child_timeout;
+            }
+        }
+        if (poll(fds.data(), fds.size(), timeout) == -1 && errno != EINTR) {
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+        }
+
+        // Reap every child that has exited; wait4 on its own pid leaves other children alone
+        for (size_t i = 0; i < running.size();) {
+            Running& child = running[i];
+            LaunchResult& result = results[child.index];
+            if (!child.reaped) {
+                int status;
+                rusage usage;
+                pid_t waited = wait4(child.pid, &status, WNOHANG, &usage);
+                if (waited == 0 || (waited == -1 && errno == EINTR)) {
+                    ++i;
+                    continue;
+                }
+                result.wall_seconds = seconds_since(child.started);
+                if (waited == child.pid) {
+                    set_exit_status(result, status, usage);
+                }
+                if (child.pidfd >= 0) {
+                    close(child.pidfd);
+                    child.pidfd = -1;
+                }
+                child.reaped = true;
+            }
+            if (kill_pending(child.pid, child.escalation)) {
+                ++i;    // Keeps its slot until check_deadline sends SIGKILL
+                continue;
+            }
+            release_cgroup(child.cgroup_path, &result);
+            running[i] = running.back();
+            running.pop_back();
+        }
+    }
+#endif
+
+    return results;
+}
@@ -1,6 +1,12 @@
 #ifndef LAUNCH_LIB_H
 #define LAUNCH_LIB_H
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -8,6 +14,89 @@
 #include <unistd.h>
 #endif
 
+// How the child process is created on Unix (Windows always uses CreateProcess)
+enum class SpawnMode {
+    PosixSpawn,  // posix_spawn(): glibc uses clone(CLONE_VM|CLONE_VFORK), no page tables are copied
+    Fork         // fork() + exec: copies the parent's page tables, gets slower as the parent grows
+};
+
+struct LaunchOptions {
+    bool wait_for_exit = true;
+    // true: run the command through "/bin/sh -c";
+    // false: split it on whitespace and exec the program directly (PATH lookup, no quoting)
+    bool use_shell = true;
+    SpawnMode spawn_mode = SpawnMode::PosixSpawn;
+
+    // Output capture (launch_and_wait only). Captured streams are read through
+    // pipes while the child runs; other streams go to the parent's stdout/stderr.
+    std::string* stdout_buffer = nullptr;   // Captured stdout is appended here
+    std::string* stderr_buffer = nullptr;
+    // Gets every chunk of both streams as it arrives (on Windows from reader threads, one call at a time)
+    std::function<void(const char* data, size_t size, bool is_stderr)> output_callback;
+    size_t pipe_size = 1024 * 1024;         // Capture pipe capacity (Linux, F_SETPIPE_SZ)
+
+    // The child writes straight into these descriptors (file, pipe, socket) instead
+    // of a capture pipe, the parent never touches the data. Used by every launch function.
+    int stdout_fd = -1;
+    int stderr_fd = -1;
+
+    // Resource limits for the child (Unix, used by every launch function; 0 means not set).
+    // With any of them set, SpawnMode::PosixSpawn starts the child with
+    // clone(CLONE_VM|CLONE_VFORK) and applies them before exec.
+    size_t memory_limit = 0;            // Bytes: memory.max of the cgroup with cgroup_parent (the launch fails
+                                        // if it can't be written), otherwise RLIMIT_AS
+    size_t address_space_limit = 0;     // Bytes of address space (RLIMIT_AS), also with cgroup_parent
+    int cpu_time_limit = 0;             // Seconds of CPU (RLIMIT_CPU): SIGXCPU, then SIGKILL a second later
+    int nice_value = 0;                 // Niceness, 1..19 lowers the priority
+    int io_class = 0;                   // ionice class: 1 realtime, 2 best-effort, 3 idle
+    int io_level = 4;                   // ionice level 0..7 for classes 1 and 2
+    std::vector<int> cpu_affinity;      // CPUs the child may run on (empty: all, a missing CPU fails the launch)
+    // cgroup v2 directory (e.g. /sys/fs/cgroup/jobs). Every child gets its own
+    // sub-cgroup there, removed after the child exits; its cpu.stat and memory.peak
+    // cover the child and everything it starts. memory.max and memory.peak need the
+    // memory controller in the directory's cgroup.subtree_control.
+    std::string cgroup_parent;
+
+    // Deadline for launch_and_wait, launch_batch and launch_program with wait_for_exit
+    // (0: none), counted from the start; a killed child makes launch_program return -1.
+    // At the deadline, or once *cancel becomes true, the child's process group gets
+    // SIGTERM and kill_grace_ms later SIGKILL (even if the child itself has exited by
+    // then); on Windows the child's job object is terminated at once. Output read until then stays in the buffers.
+    int timeout_ms = 0;
+    int kill_grace_ms = 2000;
+    const std::atomic<bool>* cancel = nullptr;  // Checked every 20 ms; cancels the whole batch
+};
+
+// Outcome of one command in launch_and_wait and launch_batch
+struct LaunchResult {
+    int exit_code = -1;         // -1 if the command failed to start or was killed
+    int term_signal = 0;        // Signal that killed the command (Unix)
+    double wall_seconds = 0;    // From start to exit
+    double user_seconds = 0;    // CPU time of the command (from wait4/GetProcessTimes)
+    double system_seconds = 0;
+    long max_rss_kb = 0;        // Peak resident set size (Unix)
+    // Accounting of the child's own cgroup (with cgroup_parent), including its descendants
+    double cgroup_cpu_seconds = 0;
+    long long cgroup_memory_peak_kb = 0;
+    bool timed_out = false;     // Stopped because of timeout_ms
+    bool cancelled = false;     // Stopped (or never started) because of cancel
+};
+
+// All overloads return the exit code (0 if not waiting) or -1 on failure.
+// A child that is not waited for is reaped in the background, no zombies are left.
 int launch_program(const char* command, bool wait_for_exit);
+int launch_program(const char* command, const LaunchOptions& options);
+// Runs argv[0] with the given arguments directly; options.use_shell is ignored
+int launch_program(const std::vector<std::string>& argv, const LaunchOptions& options);
+
+// Runs the command, captures its output as options say and waits for it to exit
+LaunchResult launch_and_wait(const char* command, const LaunchOptions& options);
+LaunchResult launch_and_wait(const std::vector<std::string>& argv, const LaunchOptions& options);
 
-#endif
\ No newline at end of file
+// Runs the commands with at most max_parallelism of them at a time (like xargs -P)
+// and returns their results in the same order. options.wait_for_exit and
+// the capture buffers/callback are ignored.
+std::vector<LaunchResult> launch_batch(const std::vector<std::string>& commands, int max_parallelism,
+                                       const LaunchOptions& options = LaunchOptions());
+
+#endif
@@ -1,5 +1,12 @@
 #include "launch_lib.h"
 #include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <cstdlib>
+#include <unistd.h>
+#endif
 
 int main() {
     const char* command = "ls -l";  // Пример команды для Unix
@@ -13,5 +20,51 @@ int main() {
         std::cout << "Command execution failed!" << std::endl;
     }
 
+    // Пакетный запуск: не больше двух команд одновременно
+    std::vector<std::string> commands = {"sleep 1", "sleep 1", "exit 3", "sleep 1"};
+    std::vector<LaunchResult> results = launch_batch(commands, 2);
+    for (size_t i = 0; i < commands.size(); ++i) {
+        std::cout << commands[i] << ": exit code " << results[i].exit_code
+                  << ", wall " << results[i].wall_seconds << " s"
+                  << ", cpu " << results[i].user_seconds + results[i].system_seconds << " s"
+                  << ", max rss " << results[i].max_rss_kb << " KB" << std::endl;
+    }
+
+    // Перехват вывода в строки
+    std::string output, errors;
+    LaunchOptions capture;
+    capture.stdout_buffer = &output;
+    capture.stderr_buffer = &errors;
+    LaunchResult captured = launch_and_wait("echo out; echo err >&2", capture);
+    std::cout << "Captured stdout: " << output << "Captured stderr: " << errors
+              << "Exit code: " << captured.exit_code << std::endl;
+
+    // Ограничение времени: зависшая команда останавливается, вывод до этого момента сохраняется
+    std::string partial;
+    LaunchOptions limited;
+    limited.stdout_buffer = &partial;
+    limited.timeout_ms = 500;
+    LaunchResult stopped = launch_and_wait("echo started; sleep 10", limited);
+    std::cout << "Timed out: " << stopped.timed_out << ", output: " << partial
+              << "Wall time: " << stopped.wall_seconds << " s" << std::endl;
+
+#ifndef _WIN32
+    // memory_limit с cgroup_parent: в обычном каталоге memory.max не записать,
+    // и процесс без ограничения памяти не должен запуститься
+    char not_cgroup[] = "/tmp/launch_lib_XXXXXX";
+    if (mkdtemp(not_cgroup)) {
+        LaunchOptions capped;
+        capped.cgroup_parent = not_cgroup;
+        capped.memory_limit = 64 * 1024 * 1024;
+        int capped_result = launch_program("echo unlimited child started", capped);
+        std::cout << "memory.max not written: " << (capped_result == -1 ? "launch refused" : "CHILD RAN UNLIMITED")
+                  << std::endl;
+        rmdir(not_cgroup);
+        if (capped_result != -1) {
+            return 1;
+        }
+    }
+#endif
+
     return 0;
-}
\ No newline at end of file
+}
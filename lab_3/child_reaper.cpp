@@ -0,0 +1,151 @@
+#include "child_reaper.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const uint64_t kWakeToken = UINT64_MAX;
+
+static int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+ChildReaper::ChildReaper(ExitHandler onExit) : onExit(onExit), stopping(false) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Failed to set up child reaper: " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeToken;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    reaperThread = std::thread(&ChildReaper::reaperTask, this);
+}
+
+ChildReaper::~ChildReaper() {
+    stop();
+    for (const auto& entry : pidfds) {
+        close(entry.first);
+    }
+    close(wakeFd);
+    close(epollFd);
+}
+
+void ChildReaper::track(pid_t pid) {
+    int pidfd = openPidfd(pid);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pidfd < 0) {
+        polled.push_back(pid);
+        return;
+    }
+    // Процесс мог уже завершиться: pidfd зомби сразу готов к чтению
+    pidfds[pidfd] = pid;
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = static_cast<uint64_t>(pidfd);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, pidfd, &event);
+}
+
+size_t ChildReaper::active() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pidfds.size() + polled.size();
+}
+
+void ChildReaper::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+    if (reaperThread.joinable()) {
+        reaperThread.join();
+    }
+}
+
+void ChildReaper::reaperTask() {
+    epoll_event events[64];
+    while (true) {
+        int timeoutMs;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                return;
+            }
+            timeoutMs = polled.empty() ? -1 : kPollIntervalMs;
+        }
+
+        int ready = epoll_wait(epollFd, events, 64, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "Child reaper epoll_wait failed: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.u64 == kWakeToken) {
+                continue; // stop(): флаг проверим в начале цикла
+            }
+            int pidfd = static_cast<int>(events[i].data.u64);
+            pid_t pid;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pid = pidfds[pidfd];
+                pidfds.erase(pidfd);
+            }
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, pidfd, nullptr);
+            close(pidfd);
+            reap(pid);
+        }
+
+        // Запасной путь без pidfd
+        std::vector<pid_t> candidates;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            candidates = polled;
+        }
+        for (pid_t pid : candidates) {
+            int status = 0;
+            if (waitpid(pid, &status, WNOHANG) == pid) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (auto it = polled.begin(); it != polled.end(); ++it) {
+                        if (*it == pid) {
+                            polled.erase(it);
+                            break;
+                        }
+                    }
+                }
+                onExit(pid, status);
+            }
+        }
+    }
+}
+
+void ChildReaper::reap(pid_t pid) {
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, 0); // pidfd готов - процесс уже завершен, ждать не придется
+    } while (result < 0 && errno == EINTR);
+    if (result == pid) {
+        onExit(pid, status);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CHILD_REAPER_H
+#define CHILD_REAPER_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+// Собирает завершившиеся дочерние процессы в отдельном потоке, чтобы запуск
+// копий не ждал их завершения. На каждый процесс открывается pidfd, все pidfd
+// слушает один epoll; без pidfd_open (ядро старше 5.3) процессы опрашиваются
+// через waitpid(WNOHANG) раз в kPollIntervalMs.
+class ChildReaper {
+public:
+    // Вызывается из потока ChildReaper для каждого собранного процесса
+    typedef std::function<void(pid_t pid, int status)> ExitHandler;
+
+    explicit ChildReaper(ExitHandler onExit);
+    ~ChildReaper();
+
+    ChildReaper(const ChildReaper&) = delete;
+    ChildReaper& operator=(const ChildReaper&) = delete;
+
+    // Начать следить за процессом; можно вызывать из любого потока
+    void track(pid_t pid);
+    // Сколько отслеживаемых процессов еще не завершилось
+    size_t active();
+    // Останавливает поток; незавершенные процессы после выхода родителя подберет init
+    void stop();
+
+private:
+    static const int kPollIntervalMs = 100;
+
+    ExitHandler onExit;
+    int epollFd;
+    int wakeFd;                         // eventfd: будит поток при stop()
+    std::mutex mutex;
+    std::map<int, pid_t> pidfds;        // pidfd -> pid
+    std::vector<pid_t> polled;          // Процессы без pidfd
+    bool stopping;
+    std::thread reaperThread;
+
+    void reaperTask();
+    void reap(pid_t pid);
+};
+
+#endif // CHILD_REAPER_H
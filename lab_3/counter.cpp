@@ -3,30 +3,29 @@
 Counter::Counter() : count(0) {}
 
 void Counter::increment(int value) {
-    std::lock_guard<std::mutex> lock(mtx);
-    count += value;
+    count.fetch_add(value);
 }
 
 void Counter::multiply(int factor) {
-    std::lock_guard<std::mutex> lock(mtx);
     int currentValue = count.load(); // Чтение текущего значения
-    count.store(currentValue * factor); // Запись нового значения
+    // При неудаче compare_exchange сам обновляет currentValue, пересчитываем
+    while (!count.compare_exchange_weak(currentValue, currentValue * factor)) {
+    }
 }
 
 void Counter::divide(int divisor) {
-    std::lock_guard<std::mutex> lock(mtx);
-    if (divisor != 0) {
-        int currentValue = count.load(); // Чтение текущего значения
-        count.store(currentValue / divisor); // Запись нового значения
+    if (divisor == 0) {
+        return;
+    }
+    int currentValue = count.load(); // Чтение текущего значения
+    while (!count.compare_exchange_weak(currentValue, currentValue / divisor)) {
     }
 }
 
 void Counter::set(int value) {
-    std::lock_guard<std::mutex> lock(mtx);
     count.store(value); // Запись нового значения
 }
 
 int Counter::get() {
-    std::lock_guard<std::mutex> lock(mtx);
     return count.load(); // Чтение текущего значения
-}
\ No newline at end of file
+}
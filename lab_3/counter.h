@@ -2,8 +2,9 @@
 #define COUNTER_H
 
 #include <atomic>
-#include <mutex>
 
+// Счетчик без мьютекса: increment и get - одна атомарная операция (wait-free),
+// multiply/divide - циклы compare_exchange (lock-free)
 class Counter {
 public:
     Counter();
@@ -15,7 +16,6 @@ public:
 
 private:
     std::atomic<int> count; // Атомарный счетчик
-    std::mutex mtx; // Мьютекс для синхронизации
 };
 
-#endif // COUNTER_H
\ No newline at end of file
+#endif // COUNTER_H
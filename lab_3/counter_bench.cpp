@@ -0,0 +1,113 @@
+// Бенчмарк счетчиков: операций в секунду при конкуренции потоков и процессов
+// Запуск: ./counter_bench [операций_на_поток]
+#include "counter.h"
+#include "shared_counter.h"
+#include "sharded_counter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Прежняя реализация Counter (мьютекс вокруг атомика) - для сравнения
+class MutexCounter {
+public:
+    MutexCounter() : count(0) {}
+    void increment(int value = 1) { std::lock_guard<std::mutex> lock(mtx); count += value; }
+    void multiply(int factor) { std::lock_guard<std::mutex> lock(mtx); count.store(count.load() * factor); }
+    void divide(int divisor) { std::lock_guard<std::mutex> lock(mtx); if (divisor != 0) count.store(count.load() / divisor); }
+    int get() { std::lock_guard<std::mutex> lock(mtx); return count.load(); }
+
+private:
+    std::atomic<int> count;
+    std::mutex mtx;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Каждый поток делает ops операций: в основном increment, каждая сотая - multiply/divide
+template <typename CounterType>
+static void runOps(CounterType& counter, int ops) {
+    for (int i = 0; i < ops; ++i) {
+        if (i % 100 == 98) {
+            counter.multiply(2);
+        } else if (i % 100 == 99) {
+            counter.divide(2);
+        } else {
+            counter.increment();
+        }
+    }
+}
+
+// Только increment: сценарий "горячего" счетчика метрик
+template <typename CounterType>
+static void runIncrements(CounterType& counter, int ops) {
+    for (int i = 0; i < ops; ++i) {
+        counter.increment();
+    }
+}
+
+template <typename CounterType>
+static void benchThreads(const char* name, int threadCount, int ops, void (*work)(CounterType&, int)) {
+    CounterType counter;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.push_back(std::thread([&counter, ops, work] { work(counter, ops); }));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = secondsSince(start);
+    printf("%-14s threads=%-3d %12.0f ops/sec\n", name, threadCount,
+           static_cast<double>(threadCount) * ops / seconds);
+}
+
+// То же для процессов: видеть общее значение может только SharedCounter
+static void benchProcesses(int processCount, int ops) {
+    SharedCounter counter;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < processCount; ++p) {
+        if (fork() == 0) {
+            for (int i = 0; i < ops; ++i) {
+                counter.increment();
+            }
+            _exit(0);
+        }
+    }
+    while (wait(nullptr) > 0) {}
+    double seconds = secondsSince(start);
+    printf("%-14s procs=%-5d %12.0f ops/sec  (value %d, expected %lld)\n", "SharedCounter", processCount,
+           static_cast<double>(processCount) * ops / seconds, counter.get(),
+           static_cast<long long>(processCount) * ops);
+}
+
+int main(int argc, char* argv[]) {
+    int ops = argc > 1 ? atoi(argv[1]) : 200000;
+    int threadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    int processCounts[] = {1, 2, 4, 8};
+
+    printf("increment + multiply/divide:\n");
+    for (int threads : threadCounts) {
+        benchThreads<MutexCounter>("MutexCounter", threads, ops, runOps<MutexCounter>);
+        benchThreads<Counter>("Counter", threads, ops, runOps<Counter>);
+        benchThreads<SharedCounter>("SharedCounter", threads, ops, runOps<SharedCounter>);
+    }
+    printf("increment only:\n");
+    for (int threads : threadCounts) {
+        benchThreads<MutexCounter>("MutexCounter", threads, ops, runIncrements<MutexCounter>);
+        benchThreads<Counter>("Counter", threads, ops, runIncrements<Counter>);
+        benchThreads<ShardedCounter>("ShardedCounter", threads, ops, runIncrements<ShardedCounter>);
+    }
+    printf("processes:\n");
+    for (int processes : processCounts) {
+        benchProcesses(processes, ops);
+    }
+    return 0;
+}
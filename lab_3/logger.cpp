@@ -1,29 +1,284 @@
 #include "logger.h"
+#include <algorithm>
 #include <iostream>
-#include <chrono>
-#include <iomanip>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
 #include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 
-Logger::Logger(const std::string& filename) {
-    logFile.open(filename, std::ios::app);
-    if (!logFile.is_open()) {
+static const size_t kMaxBatch = 256; // Записей за один write()
+
+// "YYYY-MM-DD HH:MM:SS.mmm message\n"; localtime_r пересчитывается раз в секунду
+static void formatRecord(std::chrono::system_clock::time_point time, const std::string& message,
+                         std::string& out, time_t& cachedSecond, char (&cachedPrefix)[32]) {
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch());
+    time_t seconds = static_cast<time_t>(sinceEpoch.count() / 1000);
+    int ms = static_cast<int>(sinceEpoch.count() % 1000);
+    if (seconds != cachedSecond) {
+        tm parts;
+        localtime_r(&seconds, &parts);
+        strftime(cachedPrefix, sizeof(cachedPrefix), "%Y-%m-%d %H:%M:%S", &parts);
+        cachedSecond = seconds;
+    }
+    char msText[8];
+    snprintf(msText, sizeof(msText), ".%03d ", ms);
+    out += cachedPrefix;
+    out += msText;
+    out += message;
+    out += '\n';
+}
+
+static void writeAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = write(fd, data.data() + offset, data.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        offset += static_cast<size_t>(written);
+    }
+}
+
+// Все живые логгеры процесса: их обходят обработчики pthread_atfork
+static std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<Logger*>& registry() {
+    static std::vector<Logger*> loggers;
+    return loggers;
+}
+
+Logger::Logger(const std::string& filename, size_t capacity, OverflowPolicy policy)
+    : synchronous(false), policy(policy), dequeuePos(0), writtenPos(0), dropped(0),
+      sync(new WriterSync), writerSleeping(false), stopping(false) {
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
         std::cerr << "Failed to open log file!" << std::endl;
     }
+
+    // Размер кольца - степень двойки, чтобы позиция в кольце бралась маской
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    slots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0, std::memory_order_relaxed);
+
+    writer.reset(new std::thread(&Logger::writerTask, this));
+
+    registerForkHandlers();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
 }
 
 Logger::~Logger() {
-    if (logFile.is_open()) {
-        logFile.close();
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& loggers = registry();
+        loggers.erase(std::remove(loggers.begin(), loggers.end(), this), loggers.end());
+    }
+
+    if (synchronous) {
+        // Поток записи остался в родителе: объект потока и примитивы синхронизации не трогаем
+        writer.release();
+        sync.release();
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sync->mutex);
+        stopping = true;
+    }
+    sync->wake.notify_one();
+    writer->join();
+    if (fd >= 0) {
+        close(fd);
     }
 }
 
 void Logger::log(const std::string& message) {
-    if (logFile.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto now_time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+    Record record = {std::chrono::system_clock::now(), message};
+
+    if (synchronous.load(std::memory_order_relaxed)) {
+        writeNow(record);
+        return;
+    }
 
-        logFile << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S.")
-                << std::setfill('0') << std::setw(3) << ms.count() << " " << message << std::endl;
+    int attempts = 0;
+    while (!tryPush(record)) {
+        if (policy != OverflowPolicy::Block) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wakeWriter();
+        if (++attempts < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
     }
-}
\ No newline at end of file
+    wakeWriter();
+}
+
+void Logger::flush() {
+    if (synchronous.load(std::memory_order_relaxed)) {
+        return; // log() уже пишет синхронно
+    }
+    size_t target = enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(sync->mutex);
+    sync->wake.notify_one();
+    sync->written.wait(lock, [&] { return writtenPos.load(std::memory_order_acquire) >= target; });
+}
+
+void Logger::registerForkHandlers() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        pthread_atfork(&Logger::prepareFork, &Logger::parentAfterFork, &Logger::childAfterFork);
+    });
+}
+
+// Перед fork(): дописываем очереди, чтобы записи родителя, сделанные до fork(),
+// легли в файл раньше записей дочернего процесса. Реестр держим заблокированным
+// до конца fork(), чтобы логгеры не создавались и не удалялись посередине.
+void Logger::prepareFork() {
+    registryMutex().lock();
+    for (Logger* logger : registry()) {
+        logger->flush();
+    }
+}
+
+void Logger::parentAfterFork() {
+    registryMutex().unlock();
+}
+
+// В дочернем процессе жив только поток, вызвавший fork(): пишем без очереди
+void Logger::childAfterFork() {
+    for (Logger* logger : registry()) {
+        logger->synchronous.store(true, std::memory_order_relaxed);
+    }
+    registryMutex().unlock();
+}
+
+// Одна запись - один write() в O_APPEND-файл
+void Logger::writeNow(const Record& record) {
+    std::string line;
+    time_t cachedSecond = -1;
+    char cachedPrefix[32];
+    formatRecord(record.time, record.message, line, cachedSecond, cachedPrefix);
+    if (fd >= 0) {
+        writeAll(fd, line);
+    }
+}
+
+// Очередь Вьюкова: sequence слота говорит, чей сейчас ход - писателя или читателя
+bool Logger::tryPush(Record& record) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[pos & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // Кольцо заполнено
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool Logger::tryPop(Record& record) {
+    Slot& slot = slots[dequeuePos & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+        return false;
+    }
+    record = std::move(slot.record);
+    slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+bool Logger::hasPending() const {
+    return slots[dequeuePos & mask].sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+}
+
+void Logger::wakeWriter() {
+    // Пара барьеров с writerTask: либо мы видим, что поток уснул, либо он видит нашу запись
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load()) {
+        std::lock_guard<std::mutex> lock(sync->mutex);
+        sync->wake.notify_one();
+    }
+}
+
+void Logger::writerTask() {
+    std::string batch;
+    uint64_t reportedDrops = 0;
+    while (true) {
+        writeRecords(batch);
+
+        if (policy == OverflowPolicy::DropAndCount) {
+            uint64_t total = dropped.load(std::memory_order_relaxed);
+            if (total > reportedDrops) {
+                Record report = {std::chrono::system_clock::now(),
+                                 "Logger: dropped " + std::to_string(total - reportedDrops) + " messages (queue full)"};
+                writeNow(report);
+                reportedDrops = total;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(sync->mutex);
+        writtenPos.store(dequeuePos, std::memory_order_release);
+        sync->written.notify_all();
+        if (hasPending()) {
+            continue;
+        }
+        if (stopping) {
+            break; // Очередь пуста - все записано
+        }
+        writerSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        sync->wake.wait(lock, [&] { return stopping || hasPending(); });
+        writerSleeping = false;
+    }
+}
+
+// Забирает из очереди все, что есть, и пишет пачками по kMaxBatch записей
+void Logger::writeRecords(std::string& batch) {
+    time_t cachedSecond = -1;
+    char cachedPrefix[32];
+    Record record;
+    while (true) {
+        size_t count = 0;
+        batch.clear();
+        while (count < kMaxBatch && tryPop(record)) {
+            formatRecord(record.time, record.message, batch, cachedSecond, cachedPrefix);
+            ++count;
+        }
+        if (count == 0) {
+            return;
+        }
+        if (fd >= 0) {
+            writeAll(fd, batch);
+        }
+    }
+}
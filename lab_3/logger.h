@@ -1,17 +1,91 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <fstream>
+#include <thread>
 
+// Что делать, если кольцевой буфер заполнен
+enum class OverflowPolicy {
+    Block,          // Ждать, пока поток записи освободит место
+    Drop,           // Молча выбросить запись
+    DropAndCount    // Выбросить и записать в лог, сколько записей потеряно
+};
+
+// Асинхронный логгер: log() кладет запись в ограниченную MPSC-очередь
+// (кольцевой буфер Вьюкова, без мьютексов), отдельный поток форматирует
+// записи и пишет их в файл пачками. Деструктор дописывает все, что в очереди.
+// Файл открыт с O_APPEND, каждая запись (или пачка целых записей) уходит
+// одним write(), поэтому строки родителя и дочерних процессов не смешиваются.
+// Перед fork() очереди всех логгеров дописываются (pthread_atfork), в дочернем
+// процессе логгер переходит в синхронный режим.
 class Logger {
 public:
-    Logger(const std::string& filename);
+    explicit Logger(const std::string& filename, size_t capacity = 1024,
+                    OverflowPolicy policy = OverflowPolicy::Block);
     ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     void log(const std::string& message);
+    // Ждет, пока все записи, добавленные до вызова, окажутся в файле
+    void flush();
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
 
 private:
-    std::ofstream logFile;
+    struct Record {
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    int fd;
+    std::atomic<bool> synchronous;  // В дочернем процессе после fork() потока записи нет
+    OverflowPolicy policy;
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) size_t dequeuePos;  // Меняет только поток записи
+    std::atomic<size_t> writtenPos;
+    std::atomic<uint64_t> dropped;
+
+    // Все, чего касается поток записи, лежит в куче: в дочернем процессе
+    // деструкторы этих объектов ждали бы поток, которого там нет
+    struct WriterSync {
+        std::mutex mutex;
+        std::condition_variable wake;       // Будит поток записи
+        std::condition_variable written;    // Будит flush()
+    };
+
+    std::unique_ptr<WriterSync> sync;
+    std::atomic<bool> writerSleeping;
+    std::atomic<bool> stopping;
+    std::unique_ptr<std::thread> writer;
+
+    static void registerForkHandlers();
+    static void prepareFork();
+    static void parentAfterFork();
+    static void childAfterFork();
+
+    void writeNow(const Record& record);
+    bool tryPush(Record& record);
+    bool tryPop(Record& record);
+    bool hasPending() const;
+    void wakeWriter();
+    void writerTask();
+    void writeRecords(std::string& batch);
 };
 
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
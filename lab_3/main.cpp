@@ -1,12 +1,12 @@
 #include "logger.h"
-#include "counter.h"
+#include "shared_counter.h"
 #include "process_manager.h"
 #include <iostream>
 #include <thread>
 #include <atomic>
 
 Logger logger("log.txt"); // Логгер
-Counter counter; // Счетчик
+SharedCounter counter; // Счетчик, общий с дочерними процессами
 
 int main() {
     ProcessManager manager(logger, counter);
@@ -18,7 +18,7 @@ int main() {
         if (input == "set") {
             int value;
             std::cin >> value;
-            counter.set(value); // Используйте метод set из класса Counter
+            counter.set(value); // Используйте метод set из класса SharedCounter
         } else if (input == "exit") {
             break;
         }
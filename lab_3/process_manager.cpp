@@ -4,76 +4,93 @@
 #include <chrono>
 #include <thread>
 #include <iostream>
-#include <atomic>
+#include <cstdio>
 
-ProcessManager::ProcessManager(Logger& logger, Counter& counter)
-    : logger(logger), counter(counter), running(false) {}
+// Рабочих процессов два - по одному на каждую копию раунда
+static const size_t kPoolWorkers = 2;
+
+// Рабочие процессы собирает и заменяет запускальщик пула, он же пишет в лог
+// об их завершении; родитель собирает только самого запускальщика
+ProcessManager::ProcessManager(Logger& logger, SharedCounter& counter)
+    : logger(logger), counter(counter),
+      pool(kPoolWorkers,
+           [this](int copy) { runCopy(copy); },
+           [this](pid_t pid, int status) { logExit("Worker", pid, status); }),
+      reaper([this](pid_t pid, int status) { logExit("Worker spawner", pid, status); }) {
+    reaper.track(pool.spawnerPid());
+}
+
+void ProcessManager::logExit(const char* process, pid_t pid, int status) {
+    std::string name = std::string(process) + " " + std::to_string(pid);
+    if (WIFEXITED(status)) {
+        logger.log(name + " exited with status " + std::to_string(WEXITSTATUS(status)));
+    } else if (WIFSIGNALED(status)) {
+        logger.log(name + " killed by signal " + std::to_string(WTERMSIG(status)));
+    }
+}
 
 void ProcessManager::start() {
-    running = true;
-    timerThread = std::thread(&ProcessManager::timerTask, this);
-    logThread = std::thread(&ProcessManager::logTask, this);
-    processThread = std::thread(&ProcessManager::processTask, this);
+    scheduler.schedulePeriodic(std::chrono::milliseconds(300), [this] { timerTask(); });
+    scheduler.schedulePeriodic(std::chrono::seconds(1), [this] { logTask(); });
+    scheduler.schedulePeriodic(std::chrono::seconds(3), [this] { processTask(); });
 }
 
+// Планировщик просыпается сразу; ждать приходится только уже идущие задачи.
+// Рабочие процессы доделывают взятые копии и завершаются сами.
 void ProcessManager::stop() {
-    running = false;
-    if (timerThread.joinable()) timerThread.join();
-    if (logThread.joinable()) logThread.join();
-    if (processThread.joinable()) processThread.join();
+    scheduler.stop();
+    pool.stop();
+    reaper.stop();
 }
 
 void ProcessManager::timerTask() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(300));
-        counter.increment();
-    }
+    counter.increment();
 }
 
 void ProcessManager::logTask() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        int count = counter.get();
-        logger.log("PID: " + std::to_string(getpid()) + " Counter: " + std::to_string(count));
-    }
+    int count = counter.get();
+    logger.log("PID: " + std::to_string(getpid()) + " Counter: " + std::to_string(count));
 }
 
 void ProcessManager::processTask() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-        spawnChildProcesses();
+    submitCopies();
+}
+
+// Копии только ставятся в очередь пула, fork() здесь не вызывается
+void ProcessManager::submitCopies() {
+    size_t running = pool.queueDepth() + pool.inProgress();
+    if (running > 0) {
+        logger.log("Previous copies still running: " + std::to_string(running));
+    }
+    char waits[64];
+    snprintf(waits, sizeof(waits), "%.2f/%.2f", pool.averageWaitMs(), pool.maxWaitMs());
+    logger.log("Pool: queue " + std::to_string(pool.queueDepth()) +
+               ", completed " + std::to_string(pool.completed()) +
+               ", lost " + std::to_string(pool.crashed()) +
+               ", wait avg/max ms " + waits);
+
+    if (!pool.submit(1)) {
+        logger.log("Failed to submit Copy 1");
+    }
+    if (!pool.submit(2)) {
+        logger.log("Failed to submit Copy 2");
     }
 }
 
-void ProcessManager::spawnChildProcesses() {
-    pid_t pid1 = fork();
-    if (pid1 == 0) {
+void ProcessManager::runCopy(int copy) {
+    if (copy == 1) {
         // Копия 1
         logger.log("Copy 1 started. PID: " + std::to_string(getpid()));
         counter.increment(10); // Увеличиваем счетчик на 10
         logger.log("Copy 1 finished. PID: " + std::to_string(getpid()));
-        exit(0); // Завершаем процесс
-    } else if (pid1 > 0) {
-        pid_t pid2 = fork();
-        if (pid2 == 0) {
-            // Копия 2
-            logger.log("Copy 2 started. PID: " + std::to_string(getpid()));
-            counter.multiply(2); // Умножаем счетчик на 2
-            logger.log("Counter multiplied by 2. New value: " + std::to_string(counter.get()));
-            std::this_thread::sleep_for(std::chrono::seconds(2)); // Ждем 2 секунды
-            counter.divide(2); // Делим счетчик на 2
-            logger.log("Counter divided by 2. New value: " + std::to_string(counter.get()));
-            logger.log("Copy 2 finished. PID: " + std::to_string(getpid()));
-            exit(0); // Завершаем процесс
-        } else if (pid2 > 0) {
-            // Родительский процесс
-            int status;
-            waitpid(pid1, &status, 0); // Ждем завершения копии 1
-            waitpid(pid2, &status, 0); // Ждем завершения копии 2
-        } else {
-            logger.log("Failed to create Copy 2");
-        }
     } else {
-        logger.log("Failed to create Copy 1");
+        // Копия 2
+        logger.log("Copy 2 started. PID: " + std::to_string(getpid()));
+        counter.multiply(2); // Умножаем счетчик на 2
+        logger.log("Counter multiplied by 2. New value: " + std::to_string(counter.get()));
+        std::this_thread::sleep_for(std::chrono::seconds(2)); // Ждем 2 секунды
+        counter.divide(2); // Делим счетчик на 2
+        logger.log("Counter divided by 2. New value: " + std::to_string(counter.get()));
+        logger.log("Copy 2 finished. PID: " + std::to_string(getpid()));
     }
-}
\ No newline at end of file
+}
@@ -2,28 +2,31 @@
 #define PROCESS_MANAGER_H
 
 #include "logger.h"
-#include "counter.h"
-#include <thread>
-#include <atomic>
+#include "shared_counter.h"
+#include "scheduler.h"
+#include "child_reaper.h"
+#include "worker_pool.h"
 
 class ProcessManager {
 public:
-    ProcessManager(Logger& logger, Counter& counter);
+    ProcessManager(Logger& logger, SharedCounter& counter);
     void start();
     void stop();
 
 private:
     Logger& logger;
-    Counter& counter;
-    std::atomic<bool> running;
-    std::thread timerThread;
-    std::thread logThread;
-    std::thread processThread;
+    SharedCounter& counter;
+    WorkerPool pool;     // Копии выполняются в заранее запущенных процессах; создается первым,
+                         // пока потоков ChildReaper и Scheduler еще нет
+    ChildReaper reaper;  // Собирает процесс-запускальщик пула
+    Scheduler scheduler; // Таймер, лог и запуск копий - периодические задачи одного планировщика
 
     void timerTask();
     void logTask();
     void processTask();
-    void spawnChildProcesses(); // Добавьте это объявление
+    void submitCopies();
+    void runCopy(int copy);     // Выполняется в рабочем процессе
+    void logExit(const char* process, pid_t pid, int status);
 };
 
-#endif // PROCESS_MANAGER_H
\ No newline at end of file
+#endif // PROCESS_MANAGER_H
@@ -0,0 +1,105 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler(size_t workerCount) : nextId(1), skipped(0), stopping(false) {
+    timerThread = std::thread(&Scheduler::timerTask, this);
+    for (size_t i = 0; i < (workerCount > 0 ? workerCount : 1); ++i) {
+        workers.push_back(std::thread(&Scheduler::workerTask, this));
+    }
+}
+
+Scheduler::~Scheduler() {
+    stop();
+}
+
+Scheduler::TaskId Scheduler::schedulePeriodic(std::chrono::milliseconds period, Task task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    TaskId id = nextId++;
+    std::shared_ptr<Job> job(new Job{id, period, task, false});
+    jobs[id] = job;
+    Timer timer = {Clock::now() + period, id};
+    timers.push(timer);
+    timerCv.notify_one(); // Новый срок может оказаться ближайшим
+    return id;
+}
+
+bool Scheduler::cancel(TaskId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Запись в куче остается, поток-таймер выбросит ее, не найдя задачу
+    return jobs.erase(id) > 0;
+}
+
+void Scheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    timerCv.notify_all();
+    readyCv.notify_all();
+    if (timerThread.joinable()) timerThread.join();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+uint64_t Scheduler::skippedRuns() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return skipped;
+}
+
+void Scheduler::timerTask() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (timers.empty()) {
+            timerCv.wait(lock);
+            continue;
+        }
+        Clock::time_point due = timers.top().due;
+        if (Clock::now() < due) {
+            timerCv.wait_until(lock, due);
+            continue; // Проснулись по сроку, регистрации или остановке - смотрим заново
+        }
+
+        Timer timer = timers.top();
+        timers.pop();
+        auto found = jobs.find(timer.id);
+        if (found == jobs.end()) {
+            continue; // Задача отменена
+        }
+        std::shared_ptr<Job> job = found->second;
+        if (job->running) {
+            ++skipped;
+        } else {
+            job->running = true;
+            ready.push_back(job);
+            readyCv.notify_one();
+        }
+
+        // Следующий срок по сетке period; если отстали больше чем на период, не догоняем
+        timer.due += job->period;
+        Clock::time_point now = Clock::now();
+        if (timer.due < now) {
+            timer.due = now + job->period;
+        }
+        timers.push(timer);
+    }
+}
+
+void Scheduler::workerTask() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        readyCv.wait(lock, [this] { return stopping || !ready.empty(); });
+        if (stopping) {
+            return;
+        }
+        std::shared_ptr<Job> job = ready.front();
+        ready.pop_front();
+
+        lock.unlock();
+        job->task();
+        lock.lock();
+        job->running = false;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Периодические задачи на одном потоке-таймере: сроки лежат в куче, поток спит
+// на condition_variable до ближайшего срока (или до регистрации/остановки) и
+// отдает наступившие задачи небольшому пулу рабочих потоков. Если прошлый
+// запуск задачи еще не закончился, очередной запуск пропускается.
+class Scheduler {
+public:
+    typedef std::function<void()> Task;
+    typedef uint64_t TaskId;
+
+    explicit Scheduler(size_t workerCount = 2);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Первый запуск через period, дальше каждые period; можно вызывать из задач
+    TaskId schedulePeriodic(std::chrono::milliseconds period, Task task);
+    // false, если задачи уже нет; идущий сейчас запуск доработает
+    bool cancel(TaskId id);
+    // Будит все потоки и ждет только уже идущие запуски
+    void stop();
+    // Сколько запусков пропущено из-за того, что прошлый еще шел
+    uint64_t skippedRuns();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Job {
+        TaskId id;
+        std::chrono::milliseconds period;
+        Task task;
+        bool running;
+    };
+
+    struct Timer {
+        Clock::time_point due;
+        TaskId id;
+        bool operator>(const Timer& other) const { return due > other.due; }
+    };
+
+    std::mutex mutex;
+    std::condition_variable timerCv;    // Будит поток-таймер
+    std::condition_variable readyCv;    // Будит рабочие потоки
+    std::map<TaskId, std::shared_ptr<Job>> jobs;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::deque<std::shared_ptr<Job>> ready;
+    TaskId nextId;
+    uint64_t skipped;
+    bool stopping;
+
+    std::thread timerThread;
+    std::vector<std::thread> workers;
+
+    void timerTask();
+    void workerTask();
+};
+
+#endif // SCHEDULER_H
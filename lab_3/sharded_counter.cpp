@@ -0,0 +1,40 @@
+#include "sharded_counter.h"
+
+// Номер потока раздается при первом обращении; слот потока - номер по модулю числа слотов
+static std::atomic<size_t> nextThreadIndex(0);
+
+static size_t threadIndex() {
+    static thread_local size_t index = nextThreadIndex.fetch_add(1);
+    return index;
+}
+
+ShardedCounter::ShardedCounter(size_t shards)
+    : shardCount(shards > 0 ? shards : 1), slots(new Slot[shardCount]) {
+    for (size_t i = 0; i < shardCount; ++i) {
+        slots[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+ShardedCounter::Slot& ShardedCounter::localSlot() {
+    return slots[threadIndex() % shardCount];
+}
+
+void ShardedCounter::increment(int value) {
+    // Слот обычно принадлежит одному потоку, relaxed достаточно
+    localSlot().value.fetch_add(value, std::memory_order_relaxed);
+}
+
+void ShardedCounter::set(int value) {
+    slots[0].value.store(value, std::memory_order_relaxed);
+    for (size_t i = 1; i < shardCount; ++i) {
+        slots[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+int ShardedCounter::get() {
+    long long sum = 0;
+    for (size_t i = 0; i < shardCount; ++i) {
+        sum += slots[i].value.load(std::memory_order_relaxed);
+    }
+    return static_cast<int>(sum);
+}
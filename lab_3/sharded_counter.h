@@ -0,0 +1,37 @@
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Счетчик для частых increment из многих потоков: у каждого потока свой слот
+// в отдельной кэш-линии, поэтому потоки не делят одну линию. get() суммирует
+// слоты и не является мгновенным снимком при параллельных increment.
+// multiply/divide здесь нет - для них нужен Counter.
+class ShardedCounter {
+public:
+    explicit ShardedCounter(size_t shards = 64);
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void increment(int value = 1);
+    // Не атомарно относительно параллельных increment
+    void set(int value);
+    int get();
+
+private:
+    // Слоты идут с шагом в кэш-линию: два значения никогда не попадают в одну линию
+    struct Slot {
+        std::atomic<long long> value;
+        char padding[64 - sizeof(std::atomic<long long>)];
+    };
+
+    size_t shardCount;
+    std::unique_ptr<Slot[]> slots;
+
+    Slot& localSlot();
+};
+
+#endif // SHARDED_COUNTER_H
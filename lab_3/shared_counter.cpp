@@ -0,0 +1,22 @@
+#include "shared_counter.h"
+#include <iostream>
+#include <new>
+#include <cstdlib>
+#include <sys/mman.h>
+
+// Между процессами атомик работает, только если он реализован без блокировок
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "std::atomic<int> must be lock-free to live in shared memory");
+
+SharedCounter::SharedCounter() {
+    void* memory = mmap(nullptr, sizeof(Counter), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map shared counter!" << std::endl;
+        exit(1);
+    }
+    counter = new (memory) Counter();
+}
+
+SharedCounter::~SharedCounter() {
+    munmap(counter, sizeof(Counter));
+}
@@ -0,0 +1,27 @@
+#ifndef SHARED_COUNTER_H
+#define SHARED_COUNTER_H
+
+#include "counter.h"
+
+// Counter в разделяемой памяти (mmap MAP_SHARED | MAP_ANONYMOUS): после fork()
+// родитель и копии работают с одним значением. Counter не использует
+// мьютексов, поэтому его операции корректны и между процессами.
+class SharedCounter {
+public:
+    SharedCounter();
+    ~SharedCounter();
+
+    SharedCounter(const SharedCounter&) = delete;
+    SharedCounter& operator=(const SharedCounter&) = delete;
+
+    void increment(int value = 1) { counter->increment(value); }
+    void multiply(int factor) { counter->multiply(factor); }
+    void divide(int divisor) { counter->divide(divisor); }
+    void set(int value) { counter->set(value); }
+    int get() { return counter->get(); }
+
+private:
+    Counter* counter; // Лежит в разделяемом сегменте
+};
+
+#endif // SHARED_COUNTER_H
@@ -0,0 +1,242 @@
+#include "worker_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "std::atomic<uint64_t> must be lock-free to live in shared memory");
+
+// steady_clock - это CLOCK_MONOTONIC, общий для всех процессов
+static int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+WorkerPool::WorkerPool(size_t workerCount, JobHandler handler, ExitHandler onExit)
+    : handler(handler), onExit(onExit), workerCount(workerCount > 0 ? workerCount : 1), spawner(-1), stopping(false) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        std::cerr << "Failed to create worker pool pipe: " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    readFd = fds[0];
+    writeFd = fds[1];
+    fcntl(writeFd, F_SETFL, O_NONBLOCK); // submit() не ждет свободного места
+
+    sharedSize = sizeof(Stats) + this->workerCount * sizeof(std::atomic<int>);
+    void* memory = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map worker pool stats!" << std::endl;
+        exit(1);
+    }
+    stats = new (memory) Stats();
+    busy = reinterpret_cast<std::atomic<int>*>(static_cast<char*>(memory) + sizeof(Stats));
+    for (size_t i = 0; i < this->workerCount; ++i) {
+        new (&busy[i]) std::atomic<int>(0);
+    }
+    stats->started = 0;
+    stats->completed = 0;
+    stats->crashed = 0;
+    stats->waitNsTotal = 0;
+    stats->waitNsMax = 0;
+
+    int control[2];
+    if (pipe2(control, O_CLOEXEC) != 0) {
+        std::cerr << "Failed to create worker pool pipe: " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    controlFd = control[1];
+
+    spawner = fork();
+    if (spawner == 0) {
+        close(writeFd);
+        close(controlFd);
+        spawnerLoop(control[0]);
+        exit(0);
+    }
+    close(control[0]);
+    if (spawner < 0) {
+        std::cerr << "Failed to start worker spawner: " << strerror(errno) << std::endl;
+        exit(1);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+    close(readFd);
+    munmap(stats, sharedSize);
+}
+
+bool WorkerPool::submit(int jobType) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return false;
+        }
+    }
+    Job job = {jobType, monotonicNs()};
+    return write(writeFd, &job, sizeof(job)) == static_cast<ssize_t>(sizeof(job));
+}
+
+void WorkerPool::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) {
+        return;
+    }
+    stopping = true;
+    close(writeFd);     // Рабочие процессы прочитают EOF
+    close(controlFd);   // Запускальщик перестанет их заменять
+}
+
+size_t WorkerPool::queueDepth() const {
+    int bytes = 0;
+    if (ioctl(readFd, FIONREAD, &bytes) != 0 || bytes < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(bytes) / sizeof(Job);
+}
+
+size_t WorkerPool::inProgress() const {
+    size_t count = 0;
+    for (size_t i = 0; i < workerCount; ++i) {
+        count += busy[i].load() != 0 ? 1 : 0;
+    }
+    return count;
+}
+
+uint64_t WorkerPool::completed() const {
+    return stats->completed.load();
+}
+
+// Считает только запускальщик, по слоту busy завершившегося процесса: у живого
+// процесса слот не проверяется, а exchange() снимает отметку, так что задание
+// не попадет в счетчик дважды
+uint64_t WorkerPool::crashed() const {
+    return stats->crashed.load();
+}
+
+double WorkerPool::averageWaitMs() const {
+    uint64_t started = stats->started.load();
+    return started ? stats->waitNsTotal.load() / 1e6 / started : 0.0;
+}
+
+double WorkerPool::maxWaitMs() const {
+    return stats->waitNsMax.load() / 1e6;
+}
+
+// Процесс-запускальщик: один поток, SIGCHLD читается через signalfd. Запускает
+// рабочие процессы, собирает завершившиеся и до остановки пула заменяет их новыми;
+// после остановки ждет, пока завершатся все, и выходит
+void WorkerPool::spawnerLoop(int controlReadFd) {
+    sigset_t childSignal;
+    sigemptyset(&childSignal);
+    sigaddset(&childSignal, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childSignal, nullptr);
+    int signalFd = signalfd(-1, &childSignal, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) {
+        std::cerr << "Failed to watch worker processes: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    workers.assign(workerCount, 0);
+    for (size_t i = 0; i < workerCount; ++i) {
+        spawnWorker(i, controlReadFd, signalFd);
+    }
+
+    bool poolStopped = false;
+    while (!poolStopped || std::count_if(workers.begin(), workers.end(), [](pid_t pid) { return pid > 0; }) > 0) {
+        pollfd fds[2] = {{signalFd, POLLIN, 0}, {controlReadFd, POLLIN, 0}};
+        if (poll(fds, poolStopped ? 1 : 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (!poolStopped && fds[1].revents != 0) {
+            poolStopped = true;
+        }
+
+        signalfd_siginfo info;
+        while (read(signalFd, &info, sizeof(info)) > 0) {}
+        int status = 0;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            auto it = std::find(workers.begin(), workers.end(), pid);
+            if (it == workers.end()) {
+                continue;
+            }
+            size_t slot = static_cast<size_t>(it - workers.begin());
+            *it = 0;
+            // Процесс, завершившийся посреди задания, уносит его с собой
+            if (busy[slot].exchange(0) != 0) {
+                stats->crashed.fetch_add(1);
+            }
+            if (onExit) {
+                onExit(pid, status);
+            }
+            if (!poolStopped) {
+                spawnWorker(slot, controlReadFd, signalFd);
+            }
+        }
+    }
+    close(signalFd);
+    close(controlReadFd);
+}
+
+// Вызывается в процессе-запускальщике
+void WorkerPool::spawnWorker(size_t slot, int controlReadFd, int signalFd) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(controlReadFd);
+        close(signalFd);
+        sigset_t childSignal;
+        sigemptyset(&childSignal);
+        sigaddset(&childSignal, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &childSignal, nullptr);
+        workerLoop(slot);
+        exit(0);
+    }
+    if (pid < 0) {
+        std::cerr << "Failed to start worker process: " << strerror(errno) << std::endl;
+        return;
+    }
+    workers[slot] = pid;
+}
+
+void WorkerPool::workerLoop(size_t slot) {
+    Job job;
+    while (true) {
+        ssize_t bytes = read(readFd, &job, sizeof(job));
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes != static_cast<ssize_t>(sizeof(job))) {
+            return; // EOF: пул остановлен
+        }
+
+        // Отметка - первое, что делается с прочитанным заданием: с этого момента
+        // падение процесса засчитывается в crashed
+        busy[slot].store(1);
+        uint64_t waitNs = static_cast<uint64_t>(std::max<int64_t>(0, monotonicNs() - job.enqueuedNs));
+        stats->started.fetch_add(1);
+        stats->waitNsTotal.fetch_add(waitNs);
+        uint64_t maxNs = stats->waitNsMax.load();
+        while (waitNs > maxNs && !stats->waitNsMax.compare_exchange_weak(maxNs, waitNs)) {
+        }
+
+        handler(job.type);
+        stats->completed.fetch_add(1);
+        busy[slot].store(0);
+    }
+}
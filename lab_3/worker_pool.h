@@ -0,0 +1,85 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <sys/types.h>
+
+// Пул заранее запущенных рабочих процессов. Задания - записи фиксированного
+// размера в общем канале (pipe): запись меньше PIPE_BUF атомарна, поэтому
+// каждый процесс читает задание целиком. Счетчики задержек лежат в разделяемой памяти.
+// Рабочие процессы запускает, собирает и заменяет после падения однопоточный
+// процесс-запускальщик: родитель форкает его один раз в конструкторе (до того,
+// как у пула появятся соседние потоки), а все дальнейшие fork() идут из него,
+// а не из многопоточного родителя.
+class WorkerPool {
+public:
+    // Выполняется в рабочем процессе
+    typedef std::function<void(int jobType)> JobHandler;
+    // Вызывается в процессе-запускальщике для каждого завершившегося рабочего процесса
+    typedef std::function<void(pid_t pid, int status)> ExitHandler;
+
+    WorkerPool(size_t workerCount, JobHandler handler, ExitHandler onExit);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Не блокирует; false, если канал заполнен или пул остановлен
+    bool submit(int jobType);
+    // Закрывает канал: процессы доделывают текущие задания и завершаются,
+    // запускальщик перестает заменять их и завершается вслед за ними
+    void stop();
+    // Процесс-запускальщик (его собирает родитель, например ChildReaper::track)
+    pid_t spawnerPid() const { return spawner; }
+
+    size_t queueDepth() const;      // Лежат в канале (FIONREAD)
+    size_t inProgress() const;      // Взяты, но еще не выполнены (занятые слоты)
+    uint64_t completed() const;
+    // Задания, потерянные вместе с упавшим процессом. Оценка снизу: не попадает
+    // только задание процесса, убитого между read() и отметкой busy (две инструкции);
+    // задание живого процесса или дважды одно задание не считается никогда
+    uint64_t crashed() const;
+    double averageWaitMs() const;   // От submit до начала выполнения
+    double maxWaitMs() const;
+
+private:
+    struct Job {
+        int type;
+        int64_t enqueuedNs;
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> started;
+        std::atomic<uint64_t> completed;
+        std::atomic<uint64_t> crashed;
+        std::atomic<uint64_t> waitNsTotal;
+        std::atomic<uint64_t> waitNsMax;
+    };
+
+    JobHandler handler;
+    ExitHandler onExit;
+    int readFd;
+    int writeFd;
+    int controlFd;                  // Канал к запускальщику: EOF - пул остановлен
+    size_t workerCount;
+    Stats* stats;                   // Разделяемая память
+    std::atomic<int>* busy;         // Там же: занят ли процесс в слоте i заданием
+    size_t sharedSize;
+    std::mutex mutex;
+    pid_t spawner;
+    bool stopping;
+
+    // Все, что ниже, выполняется в процессе-запускальщике
+    std::vector<pid_t> workers;     // pid процесса в слоте i (0 - слот пуст)
+
+    void spawnerLoop(int controlReadFd);
+    void spawnWorker(size_t slot, int controlReadFd, int signalFd);
+    void workerLoop(size_t slot);
+};
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,223 @@
+#include "log_sink.h"
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Полночь по местному времени: начало суток момента now, сдвинутое на days суток
+static time_t midnight(time_t now, int days) {
+    tm parts = {};
+#ifdef _WIN32
+    localtime_s(&parts, &now);
+#else
+    localtime_r(&now, &parts);
+#endif
+    parts.tm_hour = 0;
+    parts.tm_min = 0;
+    parts.tm_sec = 0;
+    parts.tm_mday += days;
+    parts.tm_isdst = -1;
+    return mktime(&parts);
+}
+
+// Ближайшая полночь после момента now
+static time_t nextMidnight(time_t now) {
+    return midnight(now, 1);
+}
+
+// Время последнего изменения файла, 0 - файла нет
+static time_t modifiedAt(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+static bool fileExists(const string& path) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+// Часть, отрезанная от файла base ротацией по размеру
+static string partName(const string& base, int part) {
+    return base + ".part" + to_string(part);
+}
+
+// Удаляет файл вместе с его частями
+static void removeWithParts(const string& base) {
+    remove(base.c_str());
+    for (int part = 1; remove(partName(base, part).c_str()) == 0; ++part) {}
+}
+
+// Переименовывает файл вместе с его частями
+static void renameWithParts(const string& from, const string& to) {
+    rename(from.c_str(), to.c_str());
+    for (int part = 1; rename(partName(from, part).c_str(), partName(to, part).c_str()) == 0; ++part) {}
+}
+
+LogSink::LogSink(const string& path, const LogSinkOptions& options)
+    : path(path), options(options), file(nullptr), fileSize(0), sizeParts(0),
+      nextRotation(nextMidnight(time(nullptr))), stopping(false) {
+    // Продолжаем нумерацию частей, оставшихся от прошлого запуска
+    while (fileExists(partName(path, sizeParts + 1))) {
+        ++sizeParts;
+    }
+    // Файл и части, в которые писали до сегодняшней полуночи (запуск после перерыва),
+    // сразу уходят в прошлые сутки, чтобы не смешивать их с сегодняшними строками
+    time_t lastWrite = modifiedAt(path);
+    if (sizeParts > 0) {
+        lastWrite = max(lastWrite, modifiedAt(partName(path, sizeParts)));
+    }
+    time_t now = time(nullptr);
+    bool staleDay = options.rotateDaily && lastWrite != 0 && lastWrite < midnight(now, 0);
+    openFile();
+    if (staleDay && file) {
+        rotate(false);
+    }
+    // Фоновый сброс нужен только буферизованному режиму
+    if (options.durability == Durability::Buffered) {
+        flusherThread = thread(&LogSink::flusherTask, this);
+    }
+}
+
+LogSink::~LogSink() {
+    {
+        lock_guard<mutex> lock(sinkMutex);
+        stopping = true;
+    }
+    flushCv.notify_one();
+    if (flusherThread.joinable()) {
+        flusherThread.join();
+    }
+
+    lock_guard<mutex> lock(sinkMutex);
+    flushLocked(true);
+    if (file) {
+        fclose(file);
+    }
+}
+
+void LogSink::write(const string& line) {
+    lock_guard<mutex> lock(sinkMutex);
+    bool sizeExceeded = options.maxFileSize > 0 && fileSize + line.size() + 1 > options.maxFileSize;
+    time_t now = time(nullptr);
+    bool dayChanged = options.rotateDaily && now >= nextRotation;
+    if (dayChanged && fileSize == 0 && sizeParts == 0) {
+        // За прошлые сутки ничего не записано: пустой файл становится файлом новых суток
+        nextRotation = nextMidnight(now);
+        dayChanged = false;
+    }
+    if (file && (dayChanged || (sizeExceeded && fileSize > 0))) {
+        rotate(!dayChanged);
+    }
+    if (!file && !openFile()) {
+        return;
+    }
+
+    bool wasEmpty = buffer.empty();
+    buffer += line;
+    buffer += '\n';
+    fileSize += line.size() + 1;
+
+    switch (options.durability) {
+        case Durability::Buffered:
+            if (buffer.size() >= options.bufferSize) {
+                flushLocked(false);
+            } else if (wasEmpty) {
+                flushCv.notify_one();   // Запускаем отсчет flushInterval
+            }
+            break;
+        case Durability::Flush:
+            flushLocked(false);
+            break;
+        case Durability::Sync:
+            flushLocked(true);
+            break;
+    }
+}
+
+void LogSink::flush() {
+    lock_guard<mutex> lock(sinkMutex);
+    flushLocked(options.durability == Durability::Sync);
+}
+
+bool LogSink::openFile() {
+    file = fopen(path.c_str(), "a");
+    if (!file) {
+        cerr << "Failed to open log file: " << path << endl;
+        return false;
+    }
+    // Буферизуем сами, stdio только передает готовые куски в write()
+    setvbuf(file, nullptr, _IONBF, 0);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fileSize = size > 0 ? static_cast<size_t>(size) : 0;
+    return true;
+}
+
+// По размеру: текущий файл становится следующей частью path.partN.
+// Иначе текущий файл с частями становится path.1 (path.1.partN), path.1 - path.2
+// и т.д.; самый старый удаляется вместе со своими частями
+void LogSink::rotate(bool bySize) {
+    flushLocked(options.durability == Durability::Sync);
+    fclose(file);
+    file = nullptr;
+
+    if (bySize) {
+        rename(path.c_str(), partName(path, ++sizeParts).c_str());
+        openFile();
+        return;
+    }
+
+    int keep = options.keepFiles;
+    if (keep <= 0) {
+        removeWithParts(path);
+    } else {
+        removeWithParts(path + "." + to_string(keep));
+        for (int i = keep - 1; i >= 1; --i) {
+            renameWithParts(path + "." + to_string(i), path + "." + to_string(i + 1));
+        }
+        renameWithParts(path, path + ".1");
+    }
+    sizeParts = 0;
+
+    nextRotation = nextMidnight(time(nullptr));
+    openFile();
+}
+
+void LogSink::flushLocked(bool sync) {
+    if (!file) {
+        return;
+    }
+    if (!buffer.empty()) {
+        if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            cerr << "Failed to write log file: " << path << endl;
+        }
+        buffer.clear();
+    }
+    if (sync) {
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+}
+
+// Пока буфер пуст, поток спит; первая строка дает буферу жить не дольше flushInterval
+void LogSink::flusherTask() {
+    unique_lock<mutex> lock(sinkMutex);
+    while (!stopping) {
+        flushCv.wait(lock, [this] { return stopping || !buffer.empty(); });
+        flushCv.wait_for(lock, options.flushInterval, [this] { return stopping; });
+        flushLocked(false);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Когда записанное считается сохраненным
+enum class Durability {
+    Buffered,   // Буфер сбрасывается по размеру или по таймеру
+    Flush,      // Каждая строка сразу уходит в ОС (write)
+    Sync        // Каждая строка сразу уходит на диск (write + fsync)
+};
+
+struct LogSinkOptions {
+    size_t bufferSize = 64 * 1024;                      // Сброс, когда буфер заполнен
+    std::chrono::milliseconds flushInterval{1000};      // и не реже этого интервала
+    Durability durability = Durability::Buffered;
+    // Ротация по размеру (0 - нет): файл текущих суток становится .part1, .part2, ...
+    // (чем больше номер, тем новее), при ротации в полночь части уходят вместе с сутками
+    size_t maxFileSize = 0;
+    bool rotateDaily = false;                           // Ротация в полночь
+    // Сколько старых файлов хранить (.1, .2, ...); с rotateDaily - сколько прошлых суток
+    // (вместе с их частями .1.part1, ...)
+    int keepFiles = 1;
+};
+
+// Лог-файл, открытый на все время работы: строки копятся в буфере
+// и сбрасываются по политике из LogSinkOptions. Потокобезопасен.
+class LogSink {
+public:
+    LogSink(const std::string& path, const LogSinkOptions& options = LogSinkOptions());
+    ~LogSink();
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    // Добавляет строку (перевод строки дописывается сам)
+    void write(const std::string& line);
+    void flush();
+
+private:
+    std::string path;
+    LogSinkOptions options;
+    FILE* file;
+    size_t fileSize;
+    int sizeParts;              // Сколько частей .partN уже отрезано от текущего файла
+    time_t nextRotation;        // Полночь, после которой файл ротируется
+    std::string buffer;
+
+    std::mutex sinkMutex;
+    std::condition_variable flushCv;
+    bool stopping;
+    std::thread flusherThread;
+
+    bool openFile();
+    void rotate(bool bySize);
+    void flushLocked(bool sync);
+    void flusherTask();
+};
+
+#endif // LOG_SINK_H
@@ -3,21 +3,75 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
 #include <ctime>
 #include <iomanip>
+#include <thread>
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <csignal>
+#include <pthread.h>
 #include <unistd.h>
 #endif
+#include "log_sink.h"
+#include "serial_port.h"
+#include "window_stats.h"
 
-namespace std;
+using namespace std;
 
-struct TemperatureData {
-    string timestamp;
-    double temperature;
+// Для наглядности "часовое" окно длится минуту, "суточное" - час (см. Readme)
+const int64_t kHourlyWindowMs = 60 * 1000;
+const int64_t kDailyWindowMs = 3600 * 1000;
+
+// Состояние одного датчика: текущие окна для средних
+struct SensorState {
+    string port;
+    TumblingWindow hourly{kHourlyWindowMs};
+    TumblingWindow daily{kDailyWindowMs};
+};
+
+// Лог-файлы держатся открытыми всю работу программы, потоки датчиков пишут в них общим буфером
+struct LogFiles {
+    LogSink measurements;
+    LogSink hourly;
+    LogSink daily;
+
+    LogFiles(const LogSinkOptions& measurementOptions, const LogSinkOptions& averageOptions)
+        : measurements("../logs/all_measurements.log", measurementOptions),
+          hourly("../logs/hourly_average.log", averageOptions),
+          daily("../logs/daily_average.log", averageOptions) {}
 };
 
+// Обрабатывает одну строку с порта: лог измерений и средние
+void processMeasurement(SensorState& sensor, LogFiles& logs, const string& data) {
+    double temperature = 0.0;
+    try {
+        temperature = stod(data);
+    } catch (const exception&) {
+        cerr << "Invalid data from " << sensor.port << ": '" << data << "'" << endl;
+        return;
+    }
+    time_t now = time(nullptr);
+    string timestamp = ctime(&now);
+    timestamp.pop_back();
+
+    logs.measurements.write(timestamp + " [" + sensor.port + "]: " + data);
+
+    // Среднее за окно пишется первым показанием следующего окна
+    int64_t nowMs = static_cast<int64_t>(now) * 1000;
+    WindowSummary closed;
+    int64_t closedStartMs = 0;
+    if (sensor.hourly.add(nowMs, temperature, closed, closedStartMs)) {
+        logs.hourly.write(timestamp + " [" + sensor.port + "]: " + to_string(closed.average()));
+    }
+    if (sensor.daily.add(nowMs, temperature, closed, closedStartMs)) {
+        logs.daily.write(timestamp + " [" + sensor.port + "]: " + to_string(closed.average()));
+    }
+}
+
+#ifdef _WIN32
 string readFromSerialPort(const string& port) {
     ifstream serial(port);
     string data;
@@ -29,66 +83,110 @@ string readFromSerialPort(const string& port) {
     return data;
 }
 
-void writeToLog(const string& filename, const string& data) {
-    ofstream logfile(filename, ios::app);
-    if (logfile.is_open()) {
-        logfile << data << endl;
-    } else {
-        cerr << "Failed to open log file: " << filename << endl;
+// Цикл одного датчика: у каждого порта свой поток
+void readSensor(SensorState& sensor, LogFiles& logs) {
+    while (true) {
+        string data = readFromSerialPort(sensor.port);
+        if (!data.empty()) {
+            processMeasurement(sensor, logs, data);
+        }
+        Sleep(1000);
     }
 }
+#endif
 
-double calculateAverage(const vector<TemperatureData>& data) {
-    double sum = 0.0;
-    for (const auto& entry : data) {
-        sum += entry.temperature;
-    }
-    return sum / data.size();
+#ifndef _WIN32
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
 }
+#endif
 
-int main() {
+// Запуск: ./temperature_reader [--max-rate=N] [--durability=buffered|flush|sync] [--rotate-size=N] порт ...
+// --max-rate ограничивает число измерений в секунду с порта (0 - без ограничения)
+// --durability: buffered - сброс лога раз в секунду или по заполнении буфера,
+//   flush - каждая строка сразу отдается ОС, sync - каждая строка ждет записи на диск
+// --rotate-size ротирует all_measurements.log по размеру в байтах в части .partN (в полночь - всегда)
+int main(int argc, char* argv[]) {
+    double maxRate = 0.0;
+    LogSinkOptions measurementOptions;
+    measurementOptions.rotateDaily = true;
+    vector<string> ports;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.compare(0, 11, "--max-rate=") == 0) {
+            maxRate = atof(arg.c_str() + 11);
+        } else if (arg.compare(0, 13, "--durability=") == 0) {
+            string mode = arg.substr(13);
+            if (mode == "flush") {
+                measurementOptions.durability = Durability::Flush;
+            } else if (mode == "sync") {
+                measurementOptions.durability = Durability::Sync;
+            } else {
+                measurementOptions.durability = Durability::Buffered;
+            }
+        } else if (arg.compare(0, 14, "--rotate-size=") == 0) {
+            measurementOptions.maxFileSize = static_cast<size_t>(atoll(arg.c_str() + 14));
+        } else {
+            ports.push_back(arg);
+        }
+    }
+    if (ports.empty()) {
 #ifdef _WIN32
-    string port = "COM4";  // Для Windows
+        ports.push_back("COM4");  // Для Windows
 #else
-    string port = "/dev/pts/3";  // Для Unix
+        ports.push_back("/dev/pts/3");  // Для Unix
 #endif
+    }
 
-    vector<TemperatureData> hourlyData;
-    vector<TemperatureData> dailyData;
-
-    while (true) {
-        string data = readFromSerialPort(port);
-        if (!data.empty()) {
-            double temperature = stod(data);
-            time_t now = time(nullptr);
-            string timestamp = ctime(&now);
-            timestamp.pop_back();
-
-            writeToLog("../logs/all_measurements.log", timestamp + ": " + data);
-
-            TemperatureData entry = {timestamp, temperature};
-            hourlyData.push_back(entry);
-            dailyData.push_back(entry);
-
-            if (hourlyData.size() >= 60) {
-                double hourlyAverage = calculateAverage(hourlyData);
-                writeToLog("../logs/hourly_average.log", timestamp + ": " + to_string(hourlyAverage));
-                hourlyData.clear();
-            }
+    vector<SensorState> sensors(ports.size());
+    for (size_t i = 0; i < ports.size(); ++i) {
+        sensors[i].port = ports[i];
+    }
 
-            if (dailyData.size() >= 1440) {
-                double dailyAverage = calculateAverage(dailyData);
-                writeToLog("../logs/daily_average.log", timestamp + ": " + to_string(dailyAverage));
-                dailyData.clear();
-            }
-        }
+    // Средние пишутся редко, их не ротируем
+    LogSinkOptions averageOptions;
+    averageOptions.durability = measurementOptions.durability;
+#ifndef _WIN32
+    // Потоки сброса логов не должны перехватывать SIGINT/SIGTERM у основного цикла
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+#endif
+    LogFiles logs(measurementOptions, averageOptions);
 
 #ifdef _WIN32
-        Sleep(1000);
+    vector<thread> readers;
+    for (auto& sensor : sensors) {
+        readers.push_back(thread(readSensor, ref(sensor), ref(logs)));
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
 #else
-        sleep(1);
-#endif
+    // Все порты открыты постоянно и обслуживаются одним циклом epoll:
+    // поток спит, пока ни на одном порту нет данных
+    SerialMultiplexer serial;
+    serial.setMaxRate(maxRate);
+    for (const auto& sensor : sensors) {
+        serial.addPort(sensor.port);
     }
+    // По Ctrl+C/SIGTERM выходим из цикла, чтобы деструкторы LogSink сбросили буферы
+    struct sigaction action = {};
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    pthread_sigmask(SIG_UNBLOCK, &stopSignals, nullptr);
+
+    while (!stopRequested) {
+        serial.poll(-1, [&sensors, &logs](size_t index, const string& line) {
+            processMeasurement(sensors[index], logs, line);
+        });
+    }
+#endif
 
     return 0;
-}
\ No newline at end of file
+}
@@ -20,7 +20,7 @@ void sendToSerialPort(const std::string& port, const std::string& data) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     srand(time(0));
 
 #ifdef _WIN32
@@ -28,15 +28,20 @@ int main() {
 #else
     std::string port = "/dev/pts/2";  // Для Unix
 #endif
+    if (argc > 1) {
+        port = argv[1];
+    }
+    // Второй аргумент - период отправки в миллисекундах (по умолчанию 1000)
+    int intervalMs = argc > 2 ? atoi(argv[2]) : 1000;
 
     while (true) {
         double temperature = 20.0 + (rand() % 100) / 10.0;
         sendToSerialPort(port, std::to_string(temperature));
 
 #ifdef _WIN32
-        Sleep(1000);
+        Sleep(intervalMs);
 #else
-        sleep(1);
+        usleep(intervalMs * 1000);
 #endif
     }
 
@@ -1,7 +1,23 @@
+// Новые показания приходят с сервера сами (Server-Sent Events), браузер
+// переподключается после обрыва и продолжает с последнего полученного события.
+// Если сервер отказал в подписке (503: заняты все места для /stream), опрашиваем /current.
+function showCurrentTemperature(data) {
+    document.getElementById('current-temperature').innerText = `Current Temperature: ${data.temperature}°C`;
+}
+
 async function fetchCurrentTemperature() {
     const response = await fetch('/current');
-    const data = await response.json();
-    document.getElementById('current-temperature').innerText = `Current Temperature: ${data.temperature}°C`;
+    showCurrentTemperature(await response.json());
+}
+
+function subscribeCurrentTemperature() {
+    const source = new EventSource('/stream');
+    source.onmessage = (event) => showCurrentTemperature(JSON.parse(event.data));
+    source.onerror = () => {
+        if (source.readyState === EventSource.CLOSED) {
+            setInterval(fetchCurrentTemperature, 1000);
+        }
+    };
 }
 
 async function fetchStats() {
@@ -10,5 +26,5 @@ async function fetchStats() {
     document.getElementById('stats').innerText = `Stats: ${JSON.stringify(data)}`;
 }
 
-setInterval(fetchCurrentTemperature, 1000);
-fetchStats();
\ No newline at end of file
+subscribeCurrentTemperature();
+fetchStats();
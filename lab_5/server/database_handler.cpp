@@ -0,0 +1,592 @@
+#include "database_handler.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <thread>
+
+using namespace std;
+using json = nlohmann::json;
+
+// Версия схемы хранится в PRAGMA user_version
+static const int kSchemaVersion = 3;
+
+// Разрешения таблицы агрегатов: минута, час, сутки (по UTC)
+static const int64_t kRollupResolutions[] = {60 * 1000LL, 60 * 60 * 1000LL, 24 * 60 * 60 * 1000LL};
+
+// По всем датчикам берем последнюю вставленную строку: rowid растет вместе со временем
+const char* const DatabaseHandler::kCurrentAllQuery =
+    "SELECT temperature FROM temperatures ORDER BY id DESC LIMIT 1;";
+const char* const DatabaseHandler::kCurrentSensorQuery =
+    "SELECT temperature FROM temperatures WHERE sensor_id = ? ORDER BY timestamp DESC LIMIT 1;";
+// У каждого варианта свой индекс: по времени или по (датчик, время)
+const char* const DatabaseHandler::kRawStatsAllQuery = R"(
+    SELECT COUNT(*), SUM(temperature), MIN(temperature), MAX(temperature)
+    FROM temperatures
+    WHERE timestamp >= ?1 AND timestamp < ?2
+)";
+const char* const DatabaseHandler::kRawStatsSensorQuery = R"(
+    SELECT COUNT(*), SUM(temperature), MIN(temperature), MAX(temperature)
+    FROM temperatures
+    WHERE sensor_id = ?3 AND timestamp >= ?1 AND timestamp < ?2
+)";
+// sensor_id = 0 не совпадает ни с одним датчиком, поэтому ?4 выбирает режим "все датчики"
+const char* const DatabaseHandler::kRollupStatsQuery = R"(
+    SELECT SUM(count), SUM(sum), MIN(min), MAX(max)
+    FROM temperature_rollups
+    WHERE resolution = ?1 AND bucket >= ?2 AND bucket < ?3 AND (?4 = 0 OR sensor_id = ?4)
+)";
+
+// Ошибки, после которых пакет имеет смысл повторить: базу держит другое соединение
+static bool isTransient(int rc) {
+    return rc == SQLITE_BUSY || rc == SQLITE_LOCKED;
+}
+
+static int64_t floorTo(int64_t value, int64_t step) {
+    return value / step * step;
+}
+
+static int64_t ceilTo(int64_t value, int64_t step) {
+    int64_t floored = floorTo(value, step);
+    return floored < value ? floored + step : floored;
+}
+
+DatabaseHandler::DatabaseHandler(const string& dbPath, const IngestOptions& options)
+    : db(nullptr), dbPath(dbPath), options(options), stopping(false) {
+    if (this->options.batchSize == 0) {
+        this->options.batchSize = 1;
+    }
+    if (this->options.maxPending < this->options.batchSize) {
+        this->options.maxPending = this->options.batchSize;
+    }
+
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        cerr << "Error: Can't open database: " << sqlite3_errmsg(db) << endl;
+        exit(1);
+    }
+    sqlite3_busy_timeout(db, this->options.busyTimeoutMs);
+    createTable();
+
+    flusherThread = thread(&DatabaseHandler::flusherTask, this);
+    cout << "Database initialized: " << dbPath << endl;
+}
+
+DatabaseHandler::~DatabaseHandler() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+    spaceCv.notify_all(); // Будим производителей, ждущих места в полной очереди
+    if (flusherThread.joinable()) flusherThread.join();
+
+    for (auto& entry : statements) {
+        sqlite3_finalize(entry.second);
+    }
+    sqlite3_close(db);
+}
+
+int DatabaseHandler::registerSensor(const string& name) {
+    int sensorId = kAllSensors;
+    if (findSensor(name, sensorId)) {
+        return sensorId;
+    }
+
+    lock_guard<mutex> lock(dbMutex);
+    sqlite3_stmt* stmt = statement("INSERT INTO sensors (name) VALUES (?);");
+    if (!stmt) {
+        return kDefaultSensor;
+    }
+    StatementReset reset{stmt};
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        cerr << "Error registering sensor " << name << ": " << sqlite3_errmsg(db) << endl;
+        return kDefaultSensor;
+    }
+    sensorId = static_cast<int>(sqlite3_last_insert_rowid(db));
+    sensors[name] = sensorId;
+    cout << "Registered sensor '" << name << "' with id " << sensorId << endl;
+    return sensorId;
+}
+
+bool DatabaseHandler::findSensor(const string& name, int& sensorId) {
+    lock_guard<mutex> lock(dbMutex);
+    auto it = sensors.find(name);
+    if (it != sensors.end()) {
+        sensorId = it->second;
+        return true;
+    }
+
+    sqlite3_stmt* stmt = statement("SELECT id FROM sensors WHERE name = ?;");
+    if (!stmt) {
+        return false;
+    }
+    StatementReset reset{stmt};
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+    sensorId = sqlite3_column_int(stmt, 0);
+    sensors[name] = sensorId;
+    return true;
+}
+
+void DatabaseHandler::logTemperature(double temperature) {
+    logTemperature(kDefaultSensor, temperature, currentTimeMs());
+}
+
+void DatabaseHandler::logTemperature(double temperature, int64_t timestampMs) {
+    logTemperature(kDefaultSensor, temperature, timestampMs);
+}
+
+void DatabaseHandler::logTemperature(int sensorId, double temperature, int64_t timestampMs) {
+    unique_lock<mutex> lock(queueMutex);
+    // Обратное давление: не даем очереди расти, пока база не успевает
+    spaceCv.wait(lock, [this]() { return stopping || pending.size() < options.maxPending; });
+    if (stopping) {
+        // Фоновый поток уже сбрасывает очередь в последний раз, показание не попало бы в базу
+        cerr << "Error: temperature reading dropped, database is shutting down" << endl;
+        return;
+    }
+    pending.push_back({sensorId, timestampMs, temperature});
+    if (pending.size() >= options.batchSize) {
+        queueCv.notify_one();
+    }
+}
+
+void DatabaseHandler::flush() {
+    drainPending();
+}
+
+double DatabaseHandler::getCurrentTemperature(int sensorId) {
+    double result = 0.0;
+
+    lock_guard<mutex> lock(dbMutex);
+    sqlite3_stmt* stmt = statement(sensorId == kAllSensors ? kCurrentAllQuery : kCurrentSensorQuery);
+    if (!stmt) {
+        return result;
+    }
+    StatementReset reset{stmt};
+    if (sensorId != kAllSensors) {
+        sqlite3_bind_int(stmt, 1, sensorId);
+    }
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        result = sqlite3_column_double(stmt, 0);
+    } else {
+        cout << "No temperature data found in database" << endl;
+    }
+    return result;
+}
+
+json DatabaseHandler::getTemperatureStats(int64_t startMs, int64_t endMs, int sensorId) {
+    json stats = {{"average", 0.0}, {"min", 0.0}, {"max", 0.0}, {"count", 0}};
+    if (endMs < startMs) {
+        return stats;
+    }
+
+    // Дальше работаем с полуоткрытым интервалом [from, to)
+    int64_t from = startMs;
+    int64_t to = endMs < INT64_MAX ? endMs + 1 : endMs;
+
+    // Внутренняя часть, выровненная по каждому разрешению: сутки внутри часов, часы внутри минут
+    int64_t inner[3][2];
+    int64_t outerFrom = from;
+    int64_t outerTo = to;
+    for (int i = 0; i < 3; ++i) {
+        inner[i][0] = ceilTo(outerFrom, kRollupResolutions[i]);
+        inner[i][1] = floorTo(outerTo, kRollupResolutions[i]);
+        if (inner[i][0] >= inner[i][1]) {
+            inner[i][0] = inner[i][1] = outerFrom;
+        }
+        outerFrom = inner[i][0];
+        outerTo = inner[i][1];
+    }
+
+    StatsAccumulator acc;
+    lock_guard<mutex> lock(dbMutex);
+    // Сырые строки только по краям, не более минуты с каждой стороны
+    if (inner[0][0] == inner[0][1]) {
+        addRawStats(acc, sensorId, from, to);
+    } else {
+        addRawStats(acc, sensorId, from, inner[0][0]);
+        addRawStats(acc, sensorId, inner[0][1], to);
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (inner[i][0] == inner[i][1]) {
+            break;
+        }
+        bool last = i == 2 || inner[i + 1][0] == inner[i + 1][1];
+        if (last) {
+            addRollupStats(acc, sensorId, kRollupResolutions[i], inner[i][0], inner[i][1]);
+        } else {
+            addRollupStats(acc, sensorId, kRollupResolutions[i], inner[i][0], inner[i + 1][0]);
+            addRollupStats(acc, sensorId, kRollupResolutions[i], inner[i + 1][1], inner[i][1]);
+        }
+    }
+
+    if (acc.count > 0) {
+        stats["average"] = acc.sum / acc.count;
+        stats["min"] = acc.min;
+        stats["max"] = acc.max;
+        stats["count"] = acc.count;
+    }
+    return stats;
+}
+
+void DatabaseHandler::createTable() {
+    // Версия 0 хранила время строкой без индекса, ее переводим на месте
+    int version = schemaVersion();
+    if (version < 1) {
+        migrateToEpochMs();
+    }
+    // До версии 3 датчик был один: его строки относим к датчику "default",
+    // агрегаты получают датчик в ключе и строятся заново
+    if (version < 3) {
+        if (!columnType("temperatures", "timestamp").empty() && columnType("temperatures", "sensor_id").empty()) {
+            cout << "Migrating " << dbPath << ": adding sensor_id" << endl;
+            exec("ALTER TABLE temperatures ADD COLUMN sensor_id INTEGER NOT NULL DEFAULT 1;");
+        }
+        exec("DROP TABLE IF EXISTS temperature_rollups;");
+    }
+
+    // Покрывающие индексы: /current и /stats читают только их
+    const char* query = R"(
+        CREATE TABLE IF NOT EXISTS sensors (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL UNIQUE
+        );
+        INSERT OR IGNORE INTO sensors (id, name) VALUES (1, 'default');
+        CREATE TABLE IF NOT EXISTS temperatures (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp INTEGER NOT NULL,
+            temperature REAL NOT NULL,
+            sensor_id INTEGER NOT NULL DEFAULT 1
+        );
+        CREATE INDEX IF NOT EXISTS idx_temperatures_timestamp
+            ON temperatures (timestamp, temperature);
+        CREATE INDEX IF NOT EXISTS idx_temperatures_sensor_timestamp
+            ON temperatures (sensor_id, timestamp, temperature);
+        CREATE TABLE IF NOT EXISTS temperature_rollups (
+            resolution INTEGER NOT NULL,
+            bucket INTEGER NOT NULL,
+            sensor_id INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            sum REAL NOT NULL,
+            min REAL NOT NULL,
+            max REAL NOT NULL,
+            PRIMARY KEY (resolution, bucket, sensor_id)
+        ) WITHOUT ROWID;
+    )";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, query, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        cerr << "Error creating table: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        exit(1);
+    }
+    if (version < 3) {
+        backfillRollups();
+    }
+    exec(("PRAGMA user_version = " + to_string(kSchemaVersion) + ";").c_str());
+}
+
+void DatabaseHandler::migrateToEpochMs() {
+    if (columnType("temperatures", "timestamp") != "TEXT") {
+        return; // Новая база или уже переведенная
+    }
+
+    cout << "Migrating " << dbPath << ": timestamp TEXT -> INTEGER epoch ms" << endl;
+    // Старые строки записаны в местном времени, 'utc' переводит их в UTC
+    const char* query = R"(
+        BEGIN;
+        CREATE TABLE temperatures_v1 (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp INTEGER NOT NULL,
+            temperature REAL NOT NULL
+        );
+        INSERT INTO temperatures_v1 (id, timestamp, temperature)
+            SELECT id, CAST(strftime('%s', timestamp, 'utc') AS INTEGER) * 1000, temperature
+            FROM temperatures
+            WHERE strftime('%s', timestamp, 'utc') IS NOT NULL;
+        DROP TABLE temperatures;
+        ALTER TABLE temperatures_v1 RENAME TO temperatures;
+        COMMIT;
+    )";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, query, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        cerr << "Error migrating database: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        exit(1);
+    }
+}
+
+void DatabaseHandler::backfillRollups() {
+    cout << "Building temperature rollups for " << dbPath << endl;
+    bool ok = exec("BEGIN;") && exec("DELETE FROM temperature_rollups;");
+    for (int64_t resolution : kRollupResolutions) {
+        string query = "INSERT INTO temperature_rollups (resolution, bucket, sensor_id, count, sum, min, max) "
+                       "SELECT " + to_string(resolution) + ", timestamp / " + to_string(resolution) + " * " +
+                       to_string(resolution) + " AS bucket, sensor_id, COUNT(*), SUM(temperature), "
+                       "MIN(temperature), MAX(temperature) FROM temperatures GROUP BY bucket, sensor_id;";
+        ok = ok && exec(query.c_str());
+    }
+    if (!ok || !exec("COMMIT;")) {
+        exec("ROLLBACK;");
+        exit(1);
+    }
+}
+
+// Тип столбца по схеме, пустая строка - нет такого столбца или таблицы
+string DatabaseHandler::columnType(const char* table, const char* column) {
+    sqlite3_stmt* stmt = nullptr;
+    string type;
+    if (sqlite3_prepare_v2(db, "SELECT type FROM pragma_table_info(?) WHERE name = ?;",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+    }
+    sqlite3_finalize(stmt);
+    return type;
+}
+
+int DatabaseHandler::schemaVersion() {
+    sqlite3_stmt* stmt = nullptr;
+    int version = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+void DatabaseHandler::flusherTask() {
+    unique_lock<mutex> lock(queueMutex);
+    while (!stopping) {
+        queueCv.wait_for(lock, options.flushInterval, [this]() {
+            return stopping || pending.size() >= options.batchSize;
+        });
+        if (!pending.empty()) {
+            lock.unlock();
+            drainPending();
+            lock.lock();
+        }
+    }
+    lock.unlock();
+    drainPending(); // Ничего не теряем при остановке
+}
+
+void DatabaseHandler::drainPending() {
+    lock_guard<mutex> writeLock(writeMutex);
+    vector<Reading> batch;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        batch.swap(pending);
+    }
+    spaceCv.notify_all();
+
+    // Одна транзакция на batchSize показаний
+    size_t lost = 0;
+    for (size_t i = 0; i < batch.size(); i += options.batchSize) {
+        lost += writeWithRetry(batch.data() + i, min(options.batchSize, batch.size() - i));
+    }
+    if (lost > 0) {
+        cerr << "Error: lost " << lost << " of " << batch.size() << " temperature reading(s), see errors above" << endl;
+    }
+}
+
+// Пакет, который не записался из-за занятой базы, повторяется до writeRetries раз
+// с растущей паузой. Если пакет не записался по другой причине, показания пишутся
+// по одному: теряются только те, что не записываются и сами по себе.
+// Возвращает число потерянных показаний
+size_t DatabaseHandler::writeWithRetry(const Reading* first, size_t count) {
+    int rc = writeBatch(first, count);
+    for (int attempt = 1; isTransient(rc) && attempt <= options.writeRetries; ++attempt) {
+        cerr << "Warning: database is busy, retrying batch of " << count << " reading(s)" << endl;
+        this_thread::sleep_for(chrono::milliseconds(100 * attempt));
+        rc = writeBatch(first, count);
+    }
+    if (rc == SQLITE_OK) {
+        return 0;
+    }
+    if (count > 1 && !isTransient(rc)) {
+        size_t lost = 0;
+        for (size_t i = 0; i < count; ++i) {
+            lost += writeWithRetry(first + i, 1);
+        }
+        return lost;
+    }
+    return count;
+}
+
+// Пишет пакет одной транзакцией; возвращает SQLITE_OK или код ошибки
+int DatabaseHandler::writeBatch(const Reading* first, size_t count) {
+    lock_guard<mutex> lock(dbMutex);
+    sqlite3_stmt* stmt = statement("INSERT INTO temperatures (sensor_id, timestamp, temperature) VALUES (?, ?, ?);");
+    if (!stmt) {
+        return SQLITE_ERROR;
+    }
+    // IMMEDIATE берет блокировку записи сразу: занятая база ждет busyTimeoutMs здесь,
+    // а не дает SQLITE_BUSY посреди транзакции
+    if (!exec("BEGIN IMMEDIATE;")) {
+        return sqlite3_errcode(db);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        sqlite3_bind_int(stmt, 1, first[i].sensorId);
+        sqlite3_bind_int64(stmt, 2, first[i].timestampMs);
+        sqlite3_bind_double(stmt, 3, first[i].temperature);
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) {
+            cerr << "Error inserting data: " << sqlite3_errmsg(db) << endl;
+            exec("ROLLBACK;");
+            return rc;
+        }
+    }
+    sqlite3_clear_bindings(stmt);
+
+    if (!updateRollups(first, count)) {
+        int rc = sqlite3_errcode(db);
+        exec("ROLLBACK;");
+        return rc;
+    }
+
+    if (!exec("COMMIT;")) {
+        int rc = sqlite3_errcode(db);
+        exec("ROLLBACK;");
+        return rc;
+    }
+    if (options.verbose) {
+        cout << "Logged " << count << " temperature reading(s), last: "
+             << first[count - 1].temperature << "°C at " << formatTimestamp(first[count - 1].timestampMs) << endl;
+    }
+    return SQLITE_OK;
+}
+
+bool DatabaseHandler::exec(const char* query) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, query, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        cerr << "SQL error (" << query << "): " << (errMsg ? errMsg : "unknown") << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Сворачивает пакет по корзинам и добавляет его в агрегаты, вызывается внутри транзакции
+bool DatabaseHandler::updateRollups(const Reading* first, size_t count) {
+    sqlite3_stmt* stmt = statement(R"(
+        INSERT INTO temperature_rollups (resolution, bucket, sensor_id, count, sum, min, max)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+        ON CONFLICT (resolution, bucket, sensor_id) DO UPDATE SET
+            count = count + excluded.count,
+            sum = sum + excluded.sum,
+            min = MIN(min, excluded.min),
+            max = MAX(max, excluded.max);
+    )");
+    if (!stmt) {
+        return false;
+    }
+
+    for (int64_t resolution : kRollupResolutions) {
+        // Ключ корзины: (начало, датчик)
+        map<pair<int64_t, int>, StatsAccumulator> buckets;
+        for (size_t i = 0; i < count; ++i) {
+            int64_t bucket = first[i].timestampMs / resolution * resolution;
+            buckets[make_pair(bucket, first[i].sensorId)].add(first[i].temperature);
+        }
+
+        for (const auto& bucket : buckets) {
+            sqlite3_bind_int64(stmt, 1, resolution);
+            sqlite3_bind_int64(stmt, 2, bucket.first.first);
+            sqlite3_bind_int(stmt, 3, bucket.first.second);
+            sqlite3_bind_int64(stmt, 4, bucket.second.count);
+            sqlite3_bind_double(stmt, 5, bucket.second.sum);
+            sqlite3_bind_double(stmt, 6, bucket.second.min);
+            sqlite3_bind_double(stmt, 7, bucket.second.max);
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE) {
+                cerr << "Error updating rollups: " << sqlite3_errmsg(db) << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Добавляет сырые показания из [from, to), вызывается под dbMutex
+void DatabaseHandler::addRawStats(StatsAccumulator& acc, int sensorId, int64_t from, int64_t to) {
+    if (from >= to) {
+        return;
+    }
+    sqlite3_stmt* stmt = statement(sensorId == kAllSensors ? kRawStatsAllQuery : kRawStatsSensorQuery);
+    if (!stmt) {
+        return;
+    }
+    StatementReset reset{stmt};
+
+    sqlite3_bind_int64(stmt, 1, from);
+    sqlite3_bind_int64(stmt, 2, to);
+    if (sensorId != kAllSensors) {
+        sqlite3_bind_int(stmt, 3, sensorId);
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        acc.merge(sqlite3_column_int64(stmt, 0), sqlite3_column_double(stmt, 1),
+                  sqlite3_column_double(stmt, 2), sqlite3_column_double(stmt, 3));
+    }
+}
+
+// Добавляет корзины разрешения resolution, начинающиеся в [from, to), вызывается под dbMutex
+void DatabaseHandler::addRollupStats(StatsAccumulator& acc, int sensorId, int64_t resolution,
+                                     int64_t from, int64_t to) {
+    if (from >= to) {
+        return;
+    }
+    sqlite3_stmt* stmt = statement(kRollupStatsQuery);
+    if (!stmt) {
+        return;
+    }
+    StatementReset reset{stmt};
+
+    sqlite3_bind_int64(stmt, 1, resolution);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+    sqlite3_bind_int(stmt, 4, sensorId);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        acc.merge(sqlite3_column_int64(stmt, 0), sqlite3_column_double(stmt, 1),
+                  sqlite3_column_double(stmt, 2), sqlite3_column_double(stmt, 3));
+    }
+}
+
+// Возвращает скомпилированный запрос из кэша, вызывается под dbMutex
+sqlite3_stmt* DatabaseHandler::statement(const string& query) {
+    auto it = statements.find(query);
+    if (it != statements.end()) {
+        return it->second;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "Error preparing statement: " << sqlite3_errmsg(db) << endl;
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    statements.emplace(query, stmt);
+    return stmt;
+}
+
+DatabaseHandler::StatementReset::~StatementReset() {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
@@ -0,0 +1,122 @@
+#ifndef DATABASE_HANDLER_H
+#define DATABASE_HANDLER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+#include <nlohmann/json.hpp>
+
+// Параметры пакетной записи показаний в базу
+struct IngestOptions {
+    size_t batchSize = 100;                             // Сброс, как только накопилось столько показаний
+    std::chrono::milliseconds flushInterval{1000};      // ... или прошло столько времени
+    size_t maxPending = 100000;                         // Предел очереди, дальше logTemperature ждет
+    bool verbose = true;                                // Печатать сообщение о каждом сбросе
+    int busyTimeoutMs = 5000;       // Сколько ждать, пока базу держит другой процесс (sqlite3_busy_timeout)
+    int writeRetries = 3;           // Повторы пакета после SQLITE_BUSY/SQLITE_LOCKED
+};
+
+class DatabaseHandler {
+public:
+    static const int kAllSensors = 0;       // Запросы по всем датчикам сразу
+    static const int kDefaultSensor = 1;    // Датчик "default", к нему отнесены старые данные
+
+    // Запросы чтения для /current и /stats; бенчмарк печатает планы именно этих строк
+    static const char* const kCurrentAllQuery;
+    static const char* const kCurrentSensorQuery;
+    static const char* const kRawStatsAllQuery;     // ?1, ?2 - границы [from, to)
+    static const char* const kRawStatsSensorQuery;  // ... и ?3 - датчик
+    static const char* const kRollupStatsQuery;     // ?1 - разрешение, ?2, ?3 - границы, ?4 - датчик или 0
+
+    DatabaseHandler(const std::string& dbPath, const IngestOptions& options = IngestOptions());
+    ~DatabaseHandler();
+
+    // Возвращает идентификатор датчика, при необходимости заводит его
+    int registerSensor(const std::string& name);
+    // Ищет уже известный датчик, не создавая новый
+    bool findSensor(const std::string& name, int& sensorId);
+
+    // Ставит показание в очередь, запись в базу выполняет фоновый поток;
+    // после начала остановки показание отбрасывается с сообщением в stderr
+    void logTemperature(double temperature);
+    void logTemperature(double temperature, int64_t timestampMs);
+    void logTemperature(int sensorId, double temperature, int64_t timestampMs);
+    // Синхронно записывает все накопленные показания
+    void flush();
+
+    double getCurrentTemperature(int sensorId = kAllSensors);
+    // Границы периода включительно, в миллисекундах от эпохи
+    nlohmann::json getTemperatureStats(int64_t startMs, int64_t endMs, int sensorId = kAllSensors);
+
+private:
+    struct Reading {
+        int sensorId;
+        int64_t timestampMs;
+        double temperature;
+    };
+
+    // Количество, сумма, минимум и максимум части периода
+    struct StatsAccumulator {
+        int64_t count = 0;
+        double sum = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+
+        void add(double value) { merge(1, value, value, value); }
+        void merge(int64_t otherCount, double otherSum, double otherMin, double otherMax) {
+            if (otherCount <= 0) {
+                return;
+            }
+            min = count == 0 ? otherMin : std::min(min, otherMin);
+            max = count == 0 ? otherMax : std::max(max, otherMax);
+            count += otherCount;
+            sum += otherSum;
+        }
+    };
+
+    // Сбрасывает кэшированный запрос при выходе из области видимости
+    struct StatementReset {
+        sqlite3_stmt* stmt;
+        ~StatementReset();
+    };
+
+    sqlite3* db;
+    std::string dbPath;
+    IngestOptions options;
+    std::unordered_map<std::string, sqlite3_stmt*> statements; // Кэш скомпилированных запросов
+    std::unordered_map<std::string, int> sensors;              // Имя датчика -> id
+    std::mutex dbMutex;             // Защищает соединение и кэш запросов
+    std::mutex writeMutex;          // Упорядочивает сбросы очереди
+
+    std::vector<Reading> pending;   // Очередь показаний на запись
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::condition_variable spaceCv;
+    bool stopping;
+    std::thread flusherThread;
+
+    void createTable();
+    void migrateToEpochMs();
+    void backfillRollups();
+    std::string columnType(const char* table, const char* column);
+    int schemaVersion();
+    void flusherTask();
+    void drainPending();
+    size_t writeWithRetry(const Reading* first, size_t count);
+    int writeBatch(const Reading* first, size_t count);
+    bool exec(const char* query);
+    sqlite3_stmt* statement(const std::string& query);
+    bool updateRollups(const Reading* first, size_t count);
+    void addRawStats(StatsAccumulator& acc, int sensorId, int64_t from, int64_t to);
+    void addRollupStats(StatsAccumulator& acc, int sensorId, int64_t resolution, int64_t from, int64_t to);
+};
+
+#endif // DATABASE_HANDLER_H
@@ -0,0 +1,129 @@
+// Нагрузочный тест базы показаний.
+// Запуск: ./temperature_db_benchmark [число_показаний]        - скорость вставки
+//         ./temperature_db_benchmark query [число_показаний]  - запросы /current и /stats
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "database_handler.h"
+#include "timestamp.h"
+
+using namespace std;
+
+static const char* kBenchDb = "benchmark_temperature.db";
+
+// Вставляет rows показаний при заданном размере пакета, возвращает вставок в секунду
+double benchInsert(size_t batchSize, size_t rows) {
+    remove(kBenchDb);
+
+    IngestOptions options;
+    options.batchSize = batchSize;
+    options.flushInterval = chrono::milliseconds(1000);
+    options.verbose = false;
+
+    double seconds = 0.0;
+    {
+        DatabaseHandler db(kBenchDb, options);
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < rows; ++i) {
+            db.logTemperature(20.0 + (i % 100) / 10.0);
+        }
+        db.flush();
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    remove(kBenchDb);
+    return rows / seconds;
+}
+
+// Печатает план запроса, чтобы видеть, что SQLite идет по индексу. Запросы берутся
+// из DatabaseHandler, так что план - тот же, что у сервера.
+void printQueryPlan(const char* name, const char* query) {
+    cout << "  " << name << ":" << endl;
+    sqlite3* db = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_open(kBenchDb, &db);
+    string explain = string("EXPLAIN QUERY PLAN ") + query;
+    if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            cout << "    plan: " << sqlite3_column_text(stmt, 3) << endl;
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+}
+
+// Среднее время одного вызова в микросекундах
+template <typename Fn>
+double timeCalls(size_t calls, Fn fn) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        fn();
+    }
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / calls;
+}
+
+// Заполняет базу rows показаниями раз в секунду и замеряет запросы
+void benchQueries(size_t rows) {
+    remove(kBenchDb);
+
+    IngestOptions options;
+    options.batchSize = 10000;
+    options.verbose = false;
+
+    DatabaseHandler db(kBenchDb, options);
+    const int64_t stepMs = 1000;
+    const int64_t lastMs = currentTimeMs();
+    const int64_t firstMs = lastMs - static_cast<int64_t>(rows - 1) * stepMs;
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < rows; ++i) {
+        db.logTemperature(20.0 + (i % 100) / 10.0, firstMs + static_cast<int64_t>(i) * stepMs);
+    }
+    db.flush();
+    double fillSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "filled rows=" << rows << " in " << fillSeconds << " s" << endl;
+
+    cout << "query plans:" << endl;
+    printQueryPlan("current, all sensors", DatabaseHandler::kCurrentAllQuery);
+    printQueryPlan("current, one sensor", DatabaseHandler::kCurrentSensorQuery);
+    printQueryPlan("stats raw edges, all sensors", DatabaseHandler::kRawStatsAllQuery);
+    printQueryPlan("stats raw edges, one sensor", DatabaseHandler::kRawStatsSensorQuery);
+    printQueryPlan("stats rollups", DatabaseHandler::kRollupStatsQuery);
+
+    const int sensors[] = {DatabaseHandler::kAllSensors, DatabaseHandler::kDefaultSensor};
+    const char* sensorNames[] = {"all", "sensor"};
+    const int64_t ranges[] = {60 * 60 * 1000LL, 24 * 60 * 60 * 1000LL, lastMs - firstMs};
+    const char* names[] = {"hour", "day", "all"};
+    for (size_t s = 0; s < 2; ++s) {
+        int sensorId = sensors[s];
+        cout << "current(" << sensorNames[s] << "): "
+             << timeCalls(1000, [&]() { db.getCurrentTemperature(sensorId); }) << " us/query" << endl;
+        for (size_t i = 0; i < 3; ++i) {
+            double us = timeCalls(100, [&]() { db.getTemperatureStats(lastMs - ranges[i], lastMs, sensorId); });
+            cout << "stats(" << names[i] << ", " << sensorNames[s] << "): " << us << " us/query" << endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "query") {
+        benchQueries(argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000000);
+        remove(kBenchDb);
+        return 0;
+    }
+
+    size_t rows = argc > 1 ? strtoul(argv[1], nullptr, 10) : 0;
+    const size_t batchSizes[] = {1, 100, 10000};
+
+    for (size_t batchSize : batchSizes) {
+        // Без явного числа показаний берем по 100 пакетов, но не меньше 1000 строк
+        size_t n = rows ? rows : max<size_t>(1000, batchSize * 100);
+        double rate = benchInsert(batchSize, n);
+        cout << "batch=" << batchSize << " rows=" << n
+             << " inserts/sec=" << static_cast<long long>(rate) << endl;
+    }
+    return 0;
+}
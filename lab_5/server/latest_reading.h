@@ -0,0 +1,68 @@
+#ifndef LATEST_READING_H
+#define LATEST_READING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "window_stats.h"
+
+// Последнее показание и сводка за последний час на момент этого показания для /current.
+// Один поток публикует, любое число потоков читает без блокировок (seqlock):
+// читатель повторяет чтение, если попал на запись.
+class LatestReading {
+public:
+    LatestReading()
+        : sequence(0), temperature(0.0), timestampMs(0),
+          count(0), sum(0.0), min(0.0), max(0.0), mean(0.0), m2(0.0) {}
+
+    void publish(double value, int64_t timeMs, const WindowSummary& lastHour) {
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed); // Нечетное значение - идет запись
+        std::atomic_thread_fence(std::memory_order_release);
+        temperature.store(value, std::memory_order_relaxed);
+        timestampMs.store(timeMs, std::memory_order_relaxed);
+        count.store(lastHour.count, std::memory_order_relaxed);
+        sum.store(lastHour.sum, std::memory_order_relaxed);
+        min.store(lastHour.min, std::memory_order_relaxed);
+        max.store(lastHour.max, std::memory_order_relaxed);
+        mean.store(lastHour.mean, std::memory_order_relaxed);
+        m2.store(lastHour.m2, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // false, если еще ничего не опубликовано
+    bool load(double& value, int64_t& timeMs, WindowSummary& lastHour) const {
+        while (true) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            value = temperature.load(std::memory_order_relaxed);
+            timeMs = timestampMs.load(std::memory_order_relaxed);
+            lastHour.count = count.load(std::memory_order_relaxed);
+            lastHour.sum = sum.load(std::memory_order_relaxed);
+            lastHour.min = min.load(std::memory_order_relaxed);
+            lastHour.max = max.load(std::memory_order_relaxed);
+            lastHour.mean = mean.load(std::memory_order_relaxed);
+            lastHour.m2 = m2.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return before != 0;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint64_t> sequence;
+    std::atomic<double> temperature;
+    std::atomic<int64_t> timestampMs;
+    // Поля WindowSummary за последний час
+    std::atomic<size_t> count;
+    std::atomic<double> sum;
+    std::atomic<double> min;
+    std::atomic<double> max;
+    std::atomic<double> mean;
+    std::atomic<double> m2;
+};
+
+#endif // LATEST_READING_H
@@ -0,0 +1,261 @@
+// Нагрузочный тест GET /current: клиенты держат keep-alive соединения и шлют
+// запрос за запросом, следующий - сразу после ответа на предыдущий.
+// Запуск: ./temperature_load_test [клиентов=1000] [секунд=10] [хост=127.0.0.1] [порт=8080]
+// Сервер для теста: ./temperature_server --threads=1024 > /dev/null
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct Connection {
+    int fd = -1;
+    bool connected = false;
+    string request;
+    size_t sent = 0;
+    string response;
+    Clock::time_point sentAt;
+};
+
+struct Totals {
+    size_t responses = 0;
+    size_t failedResponses = 0;     // Статус не 200
+    size_t reconnects = 0;          // Сервер закрыл соединение (Connection: close, лимит keep-alive)
+    size_t connectErrors = 0;
+    vector<double> latenciesUs;
+};
+
+static bool openConnection(int epollFd, const sockaddr_in& address, Connection& conn) {
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn.fd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(conn.fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 &&
+        errno != EINPROGRESS) {
+        close(conn.fd);
+        conn.fd = -1;
+        return false;
+    }
+    conn.connected = false;
+    conn.sent = 0;
+    conn.response.clear();
+    epoll_event event = {};
+    event.events = EPOLLOUT;
+    event.data.ptr = &conn;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, conn.fd, &event);
+    return true;
+}
+
+static void closeConnection(Connection& conn) {
+    if (conn.fd >= 0) {
+        close(conn.fd);     // Заодно удаляет сокет из epoll
+        conn.fd = -1;
+    }
+}
+
+// Дописывает запрос; когда он ушел целиком, ждем ответа
+static bool sendRequest(int epollFd, Connection& conn) {
+    if (conn.sent == 0) {
+        conn.sentAt = Clock::now();
+    }
+    while (conn.sent < conn.request.size()) {
+        ssize_t written = send(conn.fd, conn.request.data() + conn.sent, conn.request.size() - conn.sent,
+                               MSG_NOSIGNAL);
+        if (written < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        conn.sent += static_cast<size_t>(written);
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &conn;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+    return true;
+}
+
+// Разбирает накопленный ответ: 1 - ответ получен целиком, 0 - нужно еще читать, -1 - ошибка
+static int parseResponse(const Connection& conn, int& status, bool& keepAlive) {
+    size_t headerEnd = conn.response.find("\r\n\r\n");
+    if (headerEnd == string::npos) {
+        return 0;
+    }
+    string headers = conn.response.substr(0, headerEnd);
+    transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+    if (sscanf(headers.c_str(), "http/1.%*d %d", &status) != 1) {
+        return -1;
+    }
+    size_t lengthPos = headers.find("\r\ncontent-length:");
+    if (lengthPos == string::npos) {
+        return -1;
+    }
+    size_t length = strtoul(headers.c_str() + lengthPos + 17, nullptr, 10);
+    if (conn.response.size() < headerEnd + 4 + length) {
+        return 0;
+    }
+    keepAlive = headers.find("\r\nconnection: close") == string::npos;
+    return 1;
+}
+
+// Читает ответ; false - соединение нужно открыть заново
+static bool readResponse(int epollFd, Connection& conn, Totals& totals, bool measuring) {
+    char buffer[16 * 1024];
+    while (true) {
+        ssize_t received = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                return false;
+            }
+            break;
+        }
+        conn.response.append(buffer, static_cast<size_t>(received));
+    }
+
+    int status = 0;
+    bool keepAlive = true;
+    int parsed = parseResponse(conn, status, keepAlive);
+    if (parsed == 0) {
+        return true;
+    }
+    if (parsed < 0) {
+        ++totals.failedResponses;
+        return false;
+    }
+    if (measuring) {
+        ++totals.responses;
+        if (status != 200) {
+            ++totals.failedResponses;
+        }
+        totals.latenciesUs.push_back(chrono::duration<double, micro>(Clock::now() - conn.sentAt).count());
+    }
+    if (!keepAlive) {
+        return false;
+    }
+    conn.response.clear();
+    conn.sent = 0;
+    return sendRequest(epollFd, conn);
+}
+
+static double percentile(const vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    size_t clients = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    double seconds = argc > 2 ? atof(argv[2]) : 10.0;
+    const char* host = argc > 3 ? argv[3] : "127.0.0.1";
+    int port = argc > 4 ? atoi(argv[4]) : 8080;
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        cerr << "Invalid IPv4 address: " << host << endl;
+        return 1;
+    }
+
+    string request = string("GET /current HTTP/1.1\r\nHost: ") + host + "\r\nConnection: keep-alive\r\n\r\n";
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    vector<Connection> connections(clients);
+    for (auto& conn : connections) {
+        conn.request = request;
+    }
+
+    Totals totals;
+    totals.latenciesUs.reserve(1 << 20);
+    vector<epoll_event> events(1024);
+
+    // Первая секунда - прогрев: соединения устанавливаются, ответы не считаются
+    const double warmupSeconds = 1.0;
+    cout << "Load test: " << clients << " keep-alive clients, GET http://" << host << ":" << port
+         << "/current for " << seconds << " s (+" << warmupSeconds << " s warm-up)" << endl;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point measureFrom = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(warmupSeconds));
+    Clock::time_point end = measureFrom + chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds));
+    for (auto& conn : connections) {
+        if (!openConnection(epollFd, address, conn)) {
+            ++totals.connectErrors;
+        }
+    }
+
+    while (true) {
+        Clock::time_point now = Clock::now();
+        if (now >= end) {
+            break;
+        }
+        bool measuring = now >= measureFrom;
+        int timeoutMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(end - now).count()) + 1;
+        int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            Connection& conn = *static_cast<Connection*>(events[i].data.ptr);
+            bool alive = true;
+            if (!conn.connected) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error != 0 || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                    ++totals.connectErrors;
+                    alive = false;
+                } else {
+                    conn.connected = true;
+                    alive = sendRequest(epollFd, conn);
+                }
+            } else if (events[i].events & EPOLLOUT) {
+                alive = sendRequest(epollFd, conn);
+            } else {
+                alive = readResponse(epollFd, conn, totals, measuring);
+            }
+            if (!alive) {
+                // Клиент, которому не удалось подключиться, выбывает из теста
+                bool reconnect = conn.connected;
+                closeConnection(conn);
+                if (reconnect) {
+                    ++totals.reconnects;
+                    if (!openConnection(epollFd, address, conn)) {
+                        ++totals.connectErrors;
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto& conn : connections) {
+        closeConnection(conn);
+    }
+    close(epollFd);
+
+    sort(totals.latenciesUs.begin(), totals.latenciesUs.end());
+    printf("Requests:    %zu (%zu failed)\n", totals.responses, totals.failedResponses);
+    printf("Throughput:  %.0f req/s\n", totals.responses / seconds);
+    printf("Latency:     p50 %.0f us, p99 %.0f us, max %.0f us\n",
+           percentile(totals.latenciesUs, 0.50), percentile(totals.latenciesUs, 0.99),
+           totals.latenciesUs.empty() ? 0.0 : totals.latenciesUs.back());
+    printf("Reconnects:  %zu, connect errors: %zu\n", totals.reconnects, totals.connectErrors);
+    return 0;
+}
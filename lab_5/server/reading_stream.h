@@ -0,0 +1,80 @@
+#ifndef READING_STREAM_H
+#define READING_STREAM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Общий буфер событий для /stream (Server-Sent Events). Показание сериализуется
+// один раз в publish() и попадает в кольцо последних событий; все подписчики
+// отправляют одну и ту же готовую строку, сколько бы их ни было.
+// Подписчик, отставший больше чем на размер кольца, продолжает с самого старого
+// события, которое еще хранится.
+class ReadingStream {
+public:
+    struct Event {
+        uint64_t id = 0;        // Номер события, он же поле id: (Last-Event-ID при переподключении)
+        int sensorId = 0;
+        std::shared_ptr<const std::string> text;    // "id: N\ndata: {...}\n\n"
+    };
+
+    explicit ReadingStream(size_t capacity = 256) : ring(capacity), nextId(1) {}
+
+    void publish(int sensorId, const std::string& data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Event& event = ring[nextId % ring.size()];
+            event.id = nextId;
+            event.sensorId = sensorId;
+            event.text = std::make_shared<const std::string>(
+                "id: " + std::to_string(nextId) + "\ndata: " + data + "\n\n");
+            ++nextId;
+        }
+        published.notify_all();
+    }
+
+    // Номер, после которого новый подписчик сразу получит последнее событие своего
+    // датчика (anySensor - любого), если оно еще в кольце; иначе - только новые события
+    uint64_t startFor(int sensorId, bool anySensor) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t oldest = nextId > ring.size() ? nextId - ring.size() : 1;
+        for (uint64_t id = nextId - 1; id >= oldest && id > 0; --id) {
+            if (anySensor || ring[id % ring.size()].sensorId == sensorId) {
+                return id - 1;
+            }
+        }
+        return nextId - 1;
+    }
+
+    // Ждет событий с номером больше afterId не дольше timeout и дописывает их
+    // в events. Возвращает номер последнего выданного события (afterId, если не дождались).
+    uint64_t wait(uint64_t afterId, std::chrono::milliseconds timeout, std::vector<Event>& events) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (afterId >= nextId) {
+            afterId = nextId - 1;   // Номер из будущего (сервер перезапускался): только новые события
+        }
+        if (!published.wait_for(lock, timeout, [&] { return nextId - 1 > afterId; })) {
+            return afterId;
+        }
+        uint64_t first = afterId + 1;
+        if (nextId - first > ring.size()) {
+            first = nextId - ring.size();
+        }
+        for (uint64_t id = first; id < nextId; ++id) {
+            events.push_back(ring[id % ring.size()]);
+        }
+        return nextId - 1;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable published;
+    std::vector<Event> ring;
+    uint64_t nextId;
+};
+
+#endif // READING_STREAM_H
@@ -1,13 +1,23 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <thread>
 #include <ctime>
 #include <cstdlib>
 #include <random>
-#include <sqlite3.h>
+#include <utility>
+#include <vector>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
+#include "database_handler.h"
+#include "latest_reading.h"
+#include "reading_stream.h"
+#include "timestamp.h"
+#include "serial_port.h"
+#include "window_stats.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -36,6 +46,8 @@ void sleep_ms(int milliseconds) {
 }
 
 // ==================== SerialReader ====================
+#ifdef _WIN32
+// В Windows порт по-прежнему опрашивается раз в секунду, в POSIX порты читает SerialMultiplexer
 class SerialReader {
 public:
     SerialReader(const string& port) : port(port) {
@@ -43,8 +55,6 @@ public:
     }
 
     string read() {
-        #ifdef _WIN32
-        // Реализация для Windows
         HANDLE hSerial = CreateFile(port.c_str(), GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
         if (hSerial == INVALID_HANDLE_VALUE) {
             cerr << "Error: Failed to open serial port: " << port << endl;
@@ -79,152 +89,116 @@ public:
 
         CloseHandle(hSerial);
         return string(buffer, bytesRead);
-
-        #else
-        // Реализация для Linux
-        ifstream serial(port);
-        if (!serial.is_open()) {
-            cerr << "Error: Failed to open serial port: " << port << endl;
-            return "";
-        }
-
-        string data;
-        if (!getline(serial, data)) {
-            cerr << "Warning: No data received from port: " << port << endl;
-            return "";
-        }
-
-        cout << "Received raw data: '" << data << "'" << endl;
-        return data;
-        #endif
     }
 
 private:
     string port;
 };
+#endif
 
-// ==================== DatabaseHandler ====================
-class DatabaseHandler {
-public:
-    DatabaseHandler(const string& dbPath) : dbPath(dbPath) {
-        if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
-            cerr << "Error: Can't open database: " << sqlite3_errmsg(db) << endl;
-            exit(1);
-        }
-        createTable();
-        cout << "Database initialized: " << dbPath << endl;
-    }
-
-    ~DatabaseHandler() {
-        sqlite3_close(db);
-    }
-
-    void logTemperature(double temperature) {
-        char timestamp[20];
-        time_t now = time(nullptr);
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
-
-        string query = "INSERT INTO temperatures (timestamp, temperature) VALUES (?, ?);";
-        sqlite3_stmt* stmt;
-        
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Error preparing statement: " << sqlite3_errmsg(db) << endl;
-            return;
-        }
-
-        sqlite3_bind_text(stmt, 1, timestamp, -1, SQLITE_STATIC);
-        sqlite3_bind_double(stmt, 2, temperature);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            cerr << "Error inserting data: " << sqlite3_errmsg(db) << endl;
-        }
-
-        sqlite3_finalize(stmt);
-        cout << "Logged temperature: " << temperature << "°C at " << timestamp << endl;
-    }
-
-    double getCurrentTemperature() {
-        string query = "SELECT temperature FROM temperatures ORDER BY timestamp DESC LIMIT 1;";
-        sqlite3_stmt* stmt;
-        double result = 0.0;
-
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Error preparing statement: " << sqlite3_errmsg(db) << endl;
-            return result;
-        }
-
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            result = sqlite3_column_double(stmt, 0);
-        } else {
-            cout << "No temperature data found in database" << endl;
-        }
-
-        sqlite3_finalize(stmt);
-        return result;
-    }
-
-    json getTemperatureStats(const string& start, const string& end) {
-        json stats = {{"average", 0.0}, {"min", 0.0}, {"max", 0.0}, {"count", 0}};
-        string query = R"(
-            SELECT 
-                AVG(temperature), 
-                MIN(temperature), 
-                MAX(temperature),
-                COUNT(*) 
-            FROM temperatures 
-            WHERE timestamp BETWEEN ? AND ?
-        )";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Error preparing statement: " << sqlite3_errmsg(db) << endl;
-            return stats;
-        }
-
-        sqlite3_bind_text(stmt, 1, start.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, end.c_str(), -1, SQLITE_STATIC);
-
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            stats["average"] = sqlite3_column_double(stmt, 0);
-            stats["min"] = sqlite3_column_double(stmt, 1);
-            stats["max"] = sqlite3_column_double(stmt, 2);
-            stats["count"] = sqlite3_column_int(stmt, 3);
-        }
+// ==================== SensorChannel ====================
+// Датчик: имя, порт и снимок последнего показания со сводкой за час для /current.
+// lastHour меняет только поток сбора данных этого датчика, /current читает снимок latest.
+struct SensorChannel {
+    string name;
+    string port;
+    int id = DatabaseHandler::kDefaultSensor;
+    LatestReading latest;
+    SlidingWindow lastHour{3600 * 1000};   // 60 минутных корзин
+};
 
-        sqlite3_finalize(stmt);
-        return stats;
-    }
+// Сводка за последний час в ответах /current и событиях /stream
+json lastHourJson(const WindowSummary& summary) {
+    return {
+        {"count", summary.count},
+        {"average", summary.average()},
+        {"min", summary.min},
+        {"max", summary.max},
+        {"stddev", summary.stddev()}
+    };
+}
 
-private:
-    sqlite3* db;
-    string dbPath;
-
-    void createTable() {
-        const char* query = R"(
-            CREATE TABLE IF NOT EXISTS temperatures (
-                id INTEGER PRIMARY KEY AUTOINCREMENT,
-                timestamp TEXT NOT NULL,
-                temperature REAL NOT NULL
-            );
-        )";
-
-        char* errMsg = nullptr;
-        if (sqlite3_exec(db, query, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-            cerr << "Error creating table: " << errMsg << endl;
-            sqlite3_free(errMsg);
-            exit(1);
-        }
-    }
+// ==================== HttpServer ====================
+// Настройки HTTP-сервера; по умолчанию - значения httplib (кроме tcpNoDelay).
+// httplib держит keep-alive соединение в одном потоке пула, пока оно открыто,
+// поэтому workerThreads - это и число одновременно обслуживаемых клиентов:
+// остальные соединения ждут в очереди, пока какое-нибудь не закроется.
+// Очередь listen() и интервал проверки простаивающих соединений задаются при сборке
+// (HTTP_LISTEN_BACKLOG, HTTP_KEEPALIVE_CHECK_INTERVAL_US в CMakeLists.txt).
+struct HttpServerOptions {
+    size_t workerThreads = CPPHTTPLIB_THREAD_POOL_COUNT;
+    size_t maxQueuedConnections = 0;                            // Сверх этого соединения закрываются (0 - без ограничения)
+    size_t keepAliveMaxCount = CPPHTTPLIB_KEEPALIVE_MAX_COUNT;  // Запросов на одно соединение
+    time_t keepAliveTimeoutSec = CPPHTTPLIB_KEEPALIVE_TIMEOUT_SECOND;   // Простой соединения между запросами
+    time_t readTimeoutSec = CPPHTTPLIB_SERVER_READ_TIMEOUT_SECOND;
+    time_t writeTimeoutSec = CPPHTTPLIB_SERVER_WRITE_TIMEOUT_SECOND;
+    // httplib пишет заголовки и тело ответа отдельно: с алгоритмом Нейгла тело ждет
+    // отложенного ACK клиента (~40 мс) на каждом keep-alive запросе
+    bool tcpNoDelay = true;
+    // Подписчики /stream занимают поток пула все время, пока подключены: httplib не
+    // умеет отдать соединение другому потоку, поэтому подписчиков не больше, чем
+    // потоков, а не тысячи. Это сознательное ограничение: общий буфер экономит
+    // сериализацию, но не потоки. Сверх лимита /stream отвечает 503, чтобы потоки
+    // оставались для /current и /stats, а клиент переходит на опрос /current.
+    // -1: пул без четверти (но не меньше двух потоков), 0 - /stream выключен;
+    // больше workerThreads - 1 не бывает
+    int maxStreamSubscribers = -1;
 };
 
 class HttpServer {
 public:
-    HttpServer(int port, DatabaseHandler& db) : port(port), db(db) {}
+    HttpServer(int port, DatabaseHandler& db, const vector<SensorChannel>& channels,
+               ReadingStream& stream, const HttpServerOptions& options = HttpServerOptions())
+        : port(port), db(db), channels(channels), stream(stream), options(options),
+          streamLimit(streamLimitFor(options)), streamSubscribers(0) {}
 
     void start() {
-        server.Get("/current", [&](const httplib::Request&, httplib::Response& res) {
-            double temp = db.getCurrentTemperature();
+        size_t workers = options.workerThreads;
+        size_t maxQueued = options.maxQueuedConnections;
+        server.new_task_queue = [workers, maxQueued] { return new httplib::ThreadPool(workers, maxQueued); };
+        server.set_keep_alive_max_count(options.keepAliveMaxCount);
+        server.set_keep_alive_timeout(options.keepAliveTimeoutSec);
+        server.set_read_timeout(options.readTimeoutSec);
+        server.set_write_timeout(options.writeTimeoutSec);
+        server.set_tcp_nodelay(options.tcpNoDelay);
+
+        server.Get("/current", [&](const httplib::Request& req, httplib::Response& res) {
+            int sensorId = DatabaseHandler::kAllSensors;
+            if (!resolveSensor(req, res, sensorId)) {
+                return;
+            }
+
+            // Отвечаем из снимков в памяти, в базу идем только пока показаний еще не было
+            double temp = 0.0;
+            int64_t timestampMs = 0;
+            bool found = false;
+            WindowSummary lastHour;
+            for (const auto& channel : channels) {
+                if (sensorId != DatabaseHandler::kAllSensors && channel.id != sensorId) {
+                    continue;
+                }
+                double value = 0.0;
+                int64_t valueMs = 0;
+                WindowSummary channelHour;
+                if (!channel.latest.load(value, valueMs, channelHour)) {
+                    continue;
+                }
+                lastHour.merge(channelHour);
+                if (!found || valueMs > timestampMs) {
+                    temp = value;
+                    timestampMs = valueMs;
+                    found = true;
+                }
+            }
+            if (!found) {
+                temp = db.getCurrentTemperature(sensorId);
+            }
+
             json response = {{"temperature", temp}, {"unit", "Celsius"}};
+            response["last_hour"] = lastHourJson(lastHour);
+            if (req.has_param("sensor")) {
+                response["sensor"] = req.get_param_value("sensor");
+            }
             res.set_content(response.dump(), "application/json");
             cout << "Served current temperature: " << temp << "°C" << endl;
         });
@@ -232,85 +206,332 @@ public:
         server.Get("/stats", [&](const httplib::Request& req, httplib::Response& res) {
             string start = req.has_param("start") ? req.get_param_value("start") : "1970-01-01";
             string end = req.has_param("end") ? req.get_param_value("end") : "2100-01-01";
-            
-            auto stats = db.getTemperatureStats(start, end);
+
+            int64_t startMs = 0;
+            int64_t endMs = 0;
+            if (!parseTimestamp(start, startMs) || !parseTimestamp(end, endMs)) {
+                json error = {{"error", "start/end must be YYYY-MM-DD[ HH:MM:SS] or epoch milliseconds"}};
+                res.status = 400;
+                res.set_content(error.dump(), "application/json");
+                return;
+            }
+
+            int sensorId = DatabaseHandler::kAllSensors;
+            if (!resolveSensor(req, res, sensorId)) {
+                return;
+            }
+
+            auto stats = db.getTemperatureStats(startMs, endMs, sensorId);
+            if (req.has_param("sensor")) {
+                stats["sensor"] = req.get_param_value("sensor");
+            }
             res.set_content(stats.dump(), "application/json");
-            
-            cout << "Served stats from " << start << " to " << end 
-                 << ": avg=" << stats["average"] << ", min=" << stats["min"] 
+
+            cout << "Served stats from " << start << " to " << end
+                 << ": avg=" << stats["average"] << ", min=" << stats["min"]
                  << ", max=" << stats["max"] << endl;
         });
 
-        cout << "Starting HTTP server on port " << port << endl;
+        // Показания по мере поступления (Server-Sent Events) из общего буфера stream:
+        // событие сериализовано один раз, здесь оно только отправляется. Подписчик
+        // занимает поток пула, пока подключен (см. HttpServerOptions).
+        server.Get("/stream", [&](const httplib::Request& req, httplib::Response& res) {
+            int sensorId = DatabaseHandler::kAllSensors;
+            if (!resolveSensor(req, res, sensorId)) {
+                return;
+            }
+
+            if (streamSubscribers.fetch_add(1) >= streamLimit) {
+                streamSubscribers.fetch_sub(1);
+                json error = {{"error", "too many /stream subscribers, poll /current instead"}};
+                res.status = 503;
+                res.set_content(error.dump(), "application/json");
+                return;
+            }
+
+            // При переподключении браузер присылает номер последнего полученного события,
+            // новый подписчик сразу получает последнее показание своего датчика
+            uint64_t lastSent = 0;
+            if (req.has_header("Last-Event-ID")) {
+                lastSent = strtoull(req.get_header_value("Last-Event-ID").c_str(), nullptr, 10);
+            } else {
+                lastSent = stream.startFor(sensorId, sensorId == DatabaseHandler::kAllSensors);
+            }
+
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider("text/event-stream",
+                [this, sensorId, lastSent](size_t, httplib::DataSink& sink) mutable {
+                    vector<ReadingStream::Event> events;
+                    lastSent = stream.wait(lastSent, chrono::seconds(15), events);
+                    string chunk;
+                    for (const auto& event : events) {
+                        if (sensorId == DatabaseHandler::kAllSensors || event.sensorId == sensorId) {
+                            chunk += *event.text;
+                        }
+                    }
+                    // Комментарий SSE: только запись обнаруживает отключившегося клиента. Подписчик
+                    // с ?sensor= получает его и тогда, когда пришли показания только других датчиков,
+                    // иначе при их постоянном потоке он не узнал бы об обрыве никогда.
+                    // Это не чаще, чем подписчик без фильтра получает события.
+                    if (chunk.empty()) {
+                        chunk = ": ping\n\n";
+                    }
+                    return sink.write(chunk.data(), chunk.size());
+                },
+                [this](bool) { streamSubscribers.fetch_sub(1); });
+        });
+
+        cout << "Starting HTTP server on port " << port << " (" << workers << " workers, up to "
+             << streamLimit << " /stream subscribers, one worker each; raise --threads for more)" << endl;
         server.listen("0.0.0.0", port);
     }
 
 private:
     int port;
     DatabaseHandler& db;
+    const vector<SensorChannel>& channels;
+    ReadingStream& stream;
+    HttpServerOptions options;
+    size_t streamLimit;
+    atomic<size_t> streamSubscribers;
     httplib::Server server;
+
+    static size_t streamLimitFor(const HttpServerOptions& options) {
+        size_t workers = options.workerThreads;
+        size_t limit = 0;
+        if (options.maxStreamSubscribers < 0) {
+            size_t reserve = workers / 4 > 2 ? workers / 4 : 2;
+            limit = workers > reserve ? workers - reserve : 0;
+        } else {
+            limit = static_cast<size_t>(options.maxStreamSubscribers);
+        }
+        return workers > 0 && limit > workers - 1 ? workers - 1 : limit;
+    }
+
+    // Параметр ?sensor=имя; без него - все датчики. Для неизвестного датчика отвечает 404
+    bool resolveSensor(const httplib::Request& req, httplib::Response& res, int& sensorId) {
+        sensorId = DatabaseHandler::kAllSensors;
+        if (!req.has_param("sensor")) {
+            return true;
+        }
+        string name = req.get_param_value("sensor");
+        if (db.findSensor(name, sensorId)) {
+            return true;
+        }
+        json error = {{"error", "unknown sensor: " + name}};
+        res.status = 404;
+        res.set_content(error.dump(), "application/json");
+        return false;
+    }
 };
 
-int main() {
+// Показание уходит в очередь записи, сразу публикуется для /current вместе со сводкой
+// за час (сводка считается здесь, на момент показания) и один раз сериализуется
+// для всех подписчиков /stream
+void ingestReading(DatabaseHandler& db, SensorChannel& channel, ReadingStream& stream, double temperature) {
+    int64_t now = currentTimeMs();
+    db.logTemperature(channel.id, temperature, now);
+    channel.lastHour.add(now, temperature);
+    WindowSummary lastHour = channel.lastHour.summary(now);
+    channel.latest.publish(temperature, now, lastHour);
+
+    json event = {{"sensor", channel.name}, {"temperature", temperature}, {"unit", "Celsius"}, {"timestamp", now}};
+    event["last_hour"] = lastHourJson(lastHour);
+    stream.publish(channel.id, event.dump());
+}
+
+#ifdef _WIN32
+// Цикл сбора данных одного датчика, у каждого порта свой поток
+void ingestLoop(DatabaseHandler& db, SensorChannel& channel, ReadingStream& stream) {
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<> dis(20.0, 30.0);
+    SerialReader reader(channel.port);
+
+    while (true) {
+        string data = reader.read();
+        double temperature = 0.0;
+
+        if (!data.empty()) {
+            try {
+                temperature = stod(data);
+                cout << "[" << channel.name << "] Parsed temperature: " << temperature << "°C" << endl;
+            } catch (const exception& e) {
+                cerr << "[" << channel.name << "] Error parsing data: " << e.what()
+                     << " (received: '" << data << "')" << endl;
+                temperature = dis(gen);
+                cout << "Using generated temperature: " << temperature << "°C" << endl;
+            }
+        } else {
+            temperature = dis(gen);
+            cout << "[" << channel.name << "] No data received, using generated: " << temperature << "°C" << endl;
+        }
+
+        ingestReading(db, channel, stream, temperature);
+        sleep_ms(1000);
+    }
+}
+#else
+// Все порты обслуживает один цикл epoll: строки разбираются сразу по приходу,
+// порт открыт постоянно и переоткрывается только после отключения
+// Чтение идет по готовности данных: подключенный, но молчащий датчик не будит цикл.
+// Если очередь записи в базу переполнена, logTemperature блокирует цикл, порты
+// перестают читаться и данные копятся в буфере ядра (обратное давление).
+void multiplexLoop(DatabaseHandler& db, vector<SensorChannel>& channels, ReadingStream& stream, double maxRate) {
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_real_distribution<> dis(20.0, 30.0);
+
+    SerialMultiplexer serial;
+    serial.setMaxRate(maxRate);
+    for (const auto& channel : channels) {
+        serial.addPort(channel.port);
+    }
+
+    // Тестовые данные генерируются раз в секунду только для неоткрытых портов
+    const int64_t simulationIntervalMs = 1000;
+    vector<int64_t> lastReadingMs(channels.size(), currentTimeMs());
+
+    while (true) {
+        int64_t deadline = INT64_MAX;
+        for (size_t i = 0; i < channels.size(); ++i) {
+            if (!serial.isOpen(i)) {
+                deadline = min(deadline, lastReadingMs[i] + simulationIntervalMs);
+            }
+        }
+        int timeoutMs = deadline == INT64_MAX
+            ? -1 : static_cast<int>(max<int64_t>(0, deadline - currentTimeMs()));
+
+        serial.poll(timeoutMs, [&](size_t index, const string& data) {
+            SensorChannel& channel = channels[index];
+            try {
+                double temperature = stod(data);
+                cout << "[" << channel.name << "] Parsed temperature: " << temperature << "°C" << endl;
+                ingestReading(db, channel, stream, temperature);
+                lastReadingMs[index] = currentTimeMs();
+            } catch (const exception& e) {
+                cerr << "[" << channel.name << "] Error parsing data: " << e.what()
+                     << " (received: '" << data << "')" << endl;
+            }
+        });
+
+        int64_t now = currentTimeMs();
+        for (size_t i = 0; i < channels.size(); ++i) {
+            if (!serial.isOpen(i) && now - lastReadingMs[i] >= simulationIntervalMs) {
+                double temperature = dis(gen);
+                cout << "[" << channels[i].name << "] No device, using generated: " << temperature << "°C" << endl;
+                ingestReading(db, channels[i], stream, temperature);
+                lastReadingMs[i] = now;
+            }
+        }
+    }
+}
+#endif
+
+// Значение параметра "--имя=значение"; false, если arg - не этот параметр
+static bool optionValue(const string& arg, const string& name, const char*& value) {
+    string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = arg.c_str() + prefix.size();
+    return true;
+}
+
+// Запуск: ./temperature_server [--max-rate=N] [--threads=N] [--max-queued=N] [--max-streams=N]
+//                              [--keep-alive-max=N] [--keep-alive-timeout=S]
+//                              [--read-timeout=S] [--write-timeout=S] [имя=]порт ...
+// Без портов читается один порт по умолчанию как датчик "default";
+// --max-rate ограничивает число показаний в секунду с порта (0 - без ограничения),
+// остальные параметры - поля HttpServerOptions
+int main(int argc, char* argv[]) {
     cout << "Starting temperature monitoring system..." << endl;
 
     // Кроссплатформенные настройки
-    const string serial_port = get_default_serial_port();
     const string db_file = "temperature.db";
     const int http_port = 8080;
 
+    double max_rate = 0.0;
+    HttpServerOptions http_options;
+    vector<pair<string, string>> sensors;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        const char* value = nullptr;
+        if (optionValue(arg, "max-rate", value)) {
+            max_rate = atof(value);
+            continue;
+        }
+        if (optionValue(arg, "threads", value)) {
+            http_options.workerThreads = strtoul(value, nullptr, 10);
+            continue;
+        }
+        if (optionValue(arg, "max-queued", value)) {
+            http_options.maxQueuedConnections = strtoul(value, nullptr, 10);
+            continue;
+        }
+        if (optionValue(arg, "max-streams", value)) {
+            http_options.maxStreamSubscribers = atoi(value);
+            continue;
+        }
+        if (optionValue(arg, "keep-alive-max", value)) {
+            http_options.keepAliveMaxCount = strtoul(value, nullptr, 10);
+            continue;
+        }
+        if (optionValue(arg, "keep-alive-timeout", value)) {
+            http_options.keepAliveTimeoutSec = atol(value);
+            continue;
+        }
+        if (optionValue(arg, "read-timeout", value)) {
+            http_options.readTimeoutSec = atol(value);
+            continue;
+        }
+        if (optionValue(arg, "write-timeout", value)) {
+            http_options.writeTimeoutSec = atol(value);
+            continue;
+        }
+        size_t eq = arg.find('=');
+        if (eq == string::npos) {
+            sensors.push_back(make_pair(arg, arg));
+        } else {
+            sensors.push_back(make_pair(arg.substr(0, eq), arg.substr(eq + 1)));
+        }
+    }
+    if (sensors.empty()) {
+        sensors.push_back(make_pair(string("default"), get_default_serial_port()));
+    }
+
     // Инициализация компонентов
     DatabaseHandler db(db_file);
-    HttpServer server(http_port, db);
+    vector<SensorChannel> channels(sensors.size());
+    for (size_t i = 0; i < sensors.size(); ++i) {
+        channels[i].name = sensors[i].first;
+        channels[i].port = sensors[i].second;
+        channels[i].id = db.registerSensor(channels[i].name);
+    }
+    if (http_options.workerThreads == 0) {
+        http_options.workerThreads = 1;
+    }
+    ReadingStream stream;
+    HttpServer server(http_port, db, channels, stream, http_options);
 
     // Запуск HTTP сервера в отдельном потоке
     thread server_thread([&server]() {
         server.start();
     });
 
-    // Основной цикл сбора данных
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_real_distribution<> dis(20.0, 30.0);
-
-    // Инициализируем SerialReader
-    try {
-        SerialReader reader(serial_port);
-
-        while (true) {
-            string data = reader.read();
-            double temperature = 0.0;
-
-            if (!data.empty()) {
-                try {
-                    temperature = stod(data);
-                    cout << "Parsed temperature: " << temperature << "°C" << endl;
-                } catch (const exception& e) {
-                    cerr << "Error parsing data: " << e.what() 
-                         << " (received: '" << data << "')" << endl;
-                    temperature = dis(gen);
-                    cout << "Using generated temperature: " << temperature << "°C" << endl;
-                }
-            } else {
-                temperature = dis(gen);
-                cout << "No data received, using generated: " << temperature << "°C" << endl;
-            }
-
-            db.logTemperature(temperature);
-            sleep_ms(1000);
-        }
-    } catch (const exception& e) {
-        cerr << "Serial port initialization failed: " << e.what() << endl;
-        cerr << "Running in simulation mode with random data" << endl;
-
-        while (true) {
-            double temperature = dis(gen);
-            db.logTemperature(temperature);
-            cout << "Generated temperature: " << temperature << "°C" << endl;
-            sleep_ms(1000);
-        }
+    // Основной цикл сбора данных: медленный порт не задерживает остальные
+#ifdef _WIN32
+    vector<thread> ingest_threads;
+    for (auto& channel : channels) {
+        ingest_threads.push_back(thread(ingestLoop, ref(db), ref(channel), ref(stream)));
     }
+    for (auto& t : ingest_threads) {
+        t.join();
+    }
+#else
+    multiplexLoop(db, channels, stream, max_rate);
+#endif
 
     server_thread.join();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#include "timestamp.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace std;
+
+int64_t currentTimeMs() {
+    return chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool parseTimestamp(const string& text, int64_t& ms) {
+    if (text.empty()) {
+        return false;
+    }
+
+    // Число без разделителей считаем готовыми миллисекундами
+    char* endPtr = nullptr;
+    long long value = strtoll(text.c_str(), &endPtr, 10);
+    if (*endPtr == '\0') {
+        ms = value;
+        return true;
+    }
+
+    tm parts = {};
+    int fields = sscanf(text.c_str(), "%d-%d-%d %d:%d:%d",
+                        &parts.tm_year, &parts.tm_mon, &parts.tm_mday,
+                        &parts.tm_hour, &parts.tm_min, &parts.tm_sec);
+    if (fields != 3 && fields != 6) {
+        return false;
+    }
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    parts.tm_isdst = -1;
+
+    time_t seconds = mktime(&parts);
+    if (seconds == static_cast<time_t>(-1)) {
+        return false;
+    }
+    ms = static_cast<int64_t>(seconds) * 1000;
+    return true;
+}
+
+string formatTimestamp(int64_t ms) {
+    time_t seconds = static_cast<time_t>(ms / 1000);
+    tm parts = {};
+    #ifdef _WIN32
+        localtime_s(&parts, &seconds);
+    #else
+        localtime_r(&seconds, &parts);
+    #endif
+
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &parts);
+    return buffer;
+}
@@ -0,0 +1,16 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Время в базе хранится как миллисекунды от эпохи (UTC)
+int64_t currentTimeMs();
+
+// Разбирает "YYYY-MM-DD", "YYYY-MM-DD HH:MM:SS" (местное время) или число миллисекунд
+bool parseTimestamp(const std::string& text, int64_t& ms);
+
+// Форматирует миллисекунды в "YYYY-MM-DD HH:MM:SS" местного времени
+std::string formatTimestamp(int64_t ms);
+
+#endif // TIMESTAMP_H